@@ -1,59 +1,207 @@
 // Generated by using Rcpp::compileAttributes() -> do not edit by hand
 // Generator token: 10BE3573-1514-4C36-9D1C-5A225CD40393
 
+#include "gsynth_types.h"
 #include <RcppArmadillo.h>
 #include <Rcpp.h>
 
 using namespace Rcpp;
 
+// boot_inter_fe
+arma::mat boot_inter_fe(const arma::mat& Y, const arma::cube& X, const arma::mat& I, int r, int force, const arma::mat& beta0, int nboots, int seed, double tol, int cores, int precision);
+RcppExport SEXP _gsynth_boot_inter_fe(SEXP YSEXP, SEXP XSEXP, SEXP ISEXP, SEXP rSEXP, SEXP forceSEXP, SEXP beta0SEXP, SEXP nbootsSEXP, SEXP seedSEXP, SEXP tolSEXP, SEXP coresSEXP, SEXP precisionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::mat& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type I(ISEXP);
+    Rcpp::traits::input_parameter< int >::type r(rSEXP);
+    Rcpp::traits::input_parameter< int >::type force(forceSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type beta0(beta0SEXP);
+    Rcpp::traits::input_parameter< int >::type nboots(nbootsSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< double >::type tol(tolSEXP);
+    Rcpp::traits::input_parameter< int >::type cores(coresSEXP);
+    Rcpp::traits::input_parameter< int >::type precision(precisionSEXP);
+    rcpp_result_gen = Rcpp::wrap(boot_inter_fe(Y, X, I, r, force, beta0, nboots, seed, tol, cores, precision));
+    return rcpp_result_gen;
+END_RCPP
+}
+// psd_factor
+arma::mat psd_factor(const arma::mat& S);
+RcppExport SEXP _gsynth_psd_factor(SEXP SSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::mat& >::type S(SSEXP);
+    rcpp_result_gen = Rcpp::wrap(psd_factor(S));
+    return rcpp_result_gen;
+END_RCPP
+}
+// mvn_draw
+arma::mat mvn_draw(const arma::mat& L, int n, int seed, int b);
+RcppExport SEXP _gsynth_mvn_draw(SEXP LSEXP, SEXP nSEXP, SEXP seedSEXP, SEXP bSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::mat& >::type L(LSEXP);
+    Rcpp::traits::input_parameter< int >::type n(nSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< int >::type b(bSEXP);
+    rcpp_result_gen = Rcpp::wrap(mvn_draw(L, n, seed, b));
+    return rcpp_result_gen;
+END_RCPP
+}
+// mvn_draw_units
+arma::cube mvn_draw_units(const arma::cube& Sigma, int nboots, int seed);
+RcppExport SEXP _gsynth_mvn_draw_units(SEXP SigmaSEXP, SEXP nbootsSEXP, SEXP seedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::cube& >::type Sigma(SigmaSEXP);
+    Rcpp::traits::input_parameter< int >::type nboots(nbootsSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    rcpp_result_gen = Rcpp::wrap(mvn_draw_units(Sigma, nboots, seed));
+    return rcpp_result_gen;
+END_RCPP
+}
+// res_vcov
+arma::mat res_vcov(const arma::mat& res, int cov_ar);
+RcppExport SEXP _gsynth_res_vcov(SEXP resSEXP, SEXP cov_arSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::mat& >::type res(resSEXP);
+    Rcpp::traits::input_parameter< int >::type cov_ar(cov_arSEXP);
+    rcpp_result_gen = Rcpp::wrap(res_vcov(res, cov_ar));
+    return rcpp_result_gen;
+END_RCPP
+}
+// cv_mc
+List cv_mc(const arma::mat& Y, const arma::cube& X, const arma::mat& I, const arma::vec& lambda, int force, double tol, int k, int seed, int cores);
+RcppExport SEXP _gsynth_cv_mc(SEXP YSEXP, SEXP XSEXP, SEXP ISEXP, SEXP lambdaSEXP, SEXP forceSEXP, SEXP tolSEXP, SEXP kSEXP, SEXP seedSEXP, SEXP coresSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::mat& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type I(ISEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type lambda(lambdaSEXP);
+    Rcpp::traits::input_parameter< int >::type force(forceSEXP);
+    Rcpp::traits::input_parameter< double >::type tol(tolSEXP);
+    Rcpp::traits::input_parameter< int >::type k(kSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< int >::type cores(coresSEXP);
+    rcpp_result_gen = Rcpp::wrap(cv_mc(Y, X, I, lambda, force, tol, k, seed, cores));
+    return rcpp_result_gen;
+END_RCPP
+}
+// loo_mspe
+double loo_mspe(const arma::mat& U, const arma::mat& F, const arma::mat& pre);
+RcppExport SEXP _gsynth_loo_mspe(SEXP USEXP, SEXP FSEXP, SEXP preSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::mat& >::type U(USEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type F(FSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type pre(preSEXP);
+    rcpp_result_gen = Rcpp::wrap(loo_mspe(U, F, pre));
+    return rcpp_result_gen;
+END_RCPP
+}
+// synth_em
+List synth_em(const arma::mat& Y, const arma::cube& X, const arma::mat& I, const arma::uvec& id_tr, const arma::mat& post, arma::mat Y_ct, arma::mat eff0, int r, int force, const arma::mat& beta0, double tol, int svd_method, int precision, Rcpp::Nullable<Rcpp::NumericMatrix> factor0);
+RcppExport SEXP _gsynth_synth_em(SEXP YSEXP, SEXP XSEXP, SEXP ISEXP, SEXP id_trSEXP, SEXP postSEXP, SEXP Y_ctSEXP, SEXP eff0SEXP, SEXP rSEXP, SEXP forceSEXP, SEXP beta0SEXP, SEXP tolSEXP, SEXP svd_methodSEXP, SEXP precisionSEXP, SEXP factor0SEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::mat& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type I(ISEXP);
+    Rcpp::traits::input_parameter< const arma::uvec& >::type id_tr(id_trSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type post(postSEXP);
+    Rcpp::traits::input_parameter< arma::mat >::type Y_ct(Y_ctSEXP);
+    Rcpp::traits::input_parameter< arma::mat >::type eff0(eff0SEXP);
+    Rcpp::traits::input_parameter< int >::type r(rSEXP);
+    Rcpp::traits::input_parameter< int >::type force(forceSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type beta0(beta0SEXP);
+    Rcpp::traits::input_parameter< double >::type tol(tolSEXP);
+    Rcpp::traits::input_parameter< int >::type svd_method(svd_methodSEXP);
+    Rcpp::traits::input_parameter< int >::type precision(precisionSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::NumericMatrix> >::type factor0(factor0SEXP);
+    rcpp_result_gen = Rcpp::wrap(synth_em(Y, X, I, id_tr, post, Y_ct, eff0, r, force, beta0, tol, svd_method, precision, factor0));
+    return rcpp_result_gen;
+END_RCPP
+}
+// set_thread_cap
+void set_thread_cap(int cap);
+RcppExport SEXP _gsynth_set_thread_cap(SEXP capSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< int >::type cap(capSEXP);
+    set_thread_cap(cap);
+    return R_NilValue;
+END_RCPP
+}
+// arma_alloc_count
+double arma_alloc_count();
+RcppExport SEXP _gsynth_arma_alloc_count() {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    rcpp_result_gen = Rcpp::wrap(arma_alloc_count());
+    return rcpp_result_gen;
+END_RCPP
+}
 // data_ub_adj
-arma::mat data_ub_adj(arma::mat I_data, arma::mat data);
+arma::mat data_ub_adj(const arma::mat& I_data, const arma::mat& data);
 RcppExport SEXP _gsynth_data_ub_adj(SEXP I_dataSEXP, SEXP dataSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< arma::mat >::type I_data(I_dataSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type data(dataSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type I_data(I_dataSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type data(dataSEXP);
     rcpp_result_gen = Rcpp::wrap(data_ub_adj(I_data, data));
     return rcpp_result_gen;
 END_RCPP
 }
 // XXinv
-arma::mat XXinv(arma::cube X);
+arma::mat XXinv(const arma::cube& X);
 RcppExport SEXP _gsynth_XXinv(SEXP XSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< arma::cube >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type X(XSEXP);
     rcpp_result_gen = Rcpp::wrap(XXinv(X));
     return rcpp_result_gen;
 END_RCPP
 }
 // Y_demean
-List Y_demean(arma::mat Y, int force);
+List Y_demean(const arma::mat& Y, int force);
 RcppExport SEXP _gsynth_Y_demean(SEXP YSEXP, SEXP forceSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< arma::mat >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type Y(YSEXP);
     Rcpp::traits::input_parameter< int >::type force(forceSEXP);
     rcpp_result_gen = Rcpp::wrap(Y_demean(Y, force));
     return rcpp_result_gen;
 END_RCPP
 }
 // fe_add
-List fe_add(arma::mat alpha_X, arma::mat xi_X, arma::mat mu_X, arma::mat alpha_Y, arma::mat xi_Y, double mu_Y, arma::mat beta, int T, int N, int p, int force);
+List fe_add(const arma::mat& alpha_X, const arma::mat& xi_X, const arma::mat& mu_X, const arma::mat& alpha_Y, const arma::mat& xi_Y, double mu_Y, const arma::mat& beta, int T, int N, int p, int force);
 RcppExport SEXP _gsynth_fe_add(SEXP alpha_XSEXP, SEXP xi_XSEXP, SEXP mu_XSEXP, SEXP alpha_YSEXP, SEXP xi_YSEXP, SEXP mu_YSEXP, SEXP betaSEXP, SEXP TSEXP, SEXP NSEXP, SEXP pSEXP, SEXP forceSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< arma::mat >::type alpha_X(alpha_XSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type xi_X(xi_XSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type mu_X(mu_XSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type alpha_Y(alpha_YSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type xi_Y(xi_YSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type alpha_X(alpha_XSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type xi_X(xi_XSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type mu_X(mu_XSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type alpha_Y(alpha_YSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type xi_Y(xi_YSEXP);
     Rcpp::traits::input_parameter< double >::type mu_Y(mu_YSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type beta(betaSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type beta(betaSEXP);
     Rcpp::traits::input_parameter< int >::type T(TSEXP);
     Rcpp::traits::input_parameter< int >::type N(NSEXP);
     Rcpp::traits::input_parameter< int >::type p(pSEXP);
@@ -63,13 +211,13 @@ BEGIN_RCPP
 END_RCPP
 }
 // fe_add2
-List fe_add2(arma::mat alpha_Y, arma::mat xi_Y, double mu_Y, int T, int N, int force);
+List fe_add2(const arma::mat& alpha_Y, const arma::mat& xi_Y, double mu_Y, int T, int N, int force);
 RcppExport SEXP _gsynth_fe_add2(SEXP alpha_YSEXP, SEXP xi_YSEXP, SEXP mu_YSEXP, SEXP TSEXP, SEXP NSEXP, SEXP forceSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< arma::mat >::type alpha_Y(alpha_YSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type xi_Y(xi_YSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type alpha_Y(alpha_YSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type xi_Y(xi_YSEXP);
     Rcpp::traits::input_parameter< double >::type mu_Y(mu_YSEXP);
     Rcpp::traits::input_parameter< int >::type T(TSEXP);
     Rcpp::traits::input_parameter< int >::type N(NSEXP);
@@ -79,240 +227,380 @@ BEGIN_RCPP
 END_RCPP
 }
 // panel_est
-arma::mat panel_est(arma::cube X, arma::mat Y, arma::mat MF);
+arma::mat panel_est(const arma::cube& X, const arma::mat& Y, const arma::mat& MF);
 RcppExport SEXP _gsynth_panel_est(SEXP XSEXP, SEXP YSEXP, SEXP MFSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< arma::cube >::type X(XSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type Y(YSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type MF(MFSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type MF(MFSEXP);
     rcpp_result_gen = Rcpp::wrap(panel_est(X, Y, MF));
     return rcpp_result_gen;
 END_RCPP
 }
 // panel_beta
-arma::mat panel_beta(arma::cube X, arma::mat xxinv, arma::mat Y, arma::mat FE);
+arma::mat panel_beta(const arma::cube& X, const arma::mat& xxinv, const arma::mat& Y, const arma::mat& FE);
 RcppExport SEXP _gsynth_panel_beta(SEXP XSEXP, SEXP xxinvSEXP, SEXP YSEXP, SEXP FESEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< arma::cube >::type X(XSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type xxinv(xxinvSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type Y(YSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type FE(FESEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type xxinv(xxinvSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type FE(FESEXP);
     rcpp_result_gen = Rcpp::wrap(panel_beta(X, xxinv, Y, FE));
     return rcpp_result_gen;
 END_RCPP
 }
 // panel_factor
-List panel_factor(arma::mat E, int r);
-RcppExport SEXP _gsynth_panel_factor(SEXP ESEXP, SEXP rSEXP) {
+List panel_factor(const arma::mat& E, int r, int svd_method, int oversample, int power);
+RcppExport SEXP _gsynth_panel_factor(SEXP ESEXP, SEXP rSEXP, SEXP svd_methodSEXP, SEXP oversampleSEXP, SEXP powerSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< arma::mat >::type E(ESEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type E(ESEXP);
     Rcpp::traits::input_parameter< int >::type r(rSEXP);
-    rcpp_result_gen = Rcpp::wrap(panel_factor(E, r));
+    Rcpp::traits::input_parameter< int >::type svd_method(svd_methodSEXP);
+    Rcpp::traits::input_parameter< int >::type oversample(oversampleSEXP);
+    Rcpp::traits::input_parameter< int >::type power(powerSEXP);
+    rcpp_result_gen = Rcpp::wrap(panel_factor(E, r, svd_method, oversample, power));
     return rcpp_result_gen;
 END_RCPP
 }
 // panel_factor_ub
-List panel_factor_ub(arma::mat E, arma::mat I, int r, double tolerate);
-RcppExport SEXP _gsynth_panel_factor_ub(SEXP ESEXP, SEXP ISEXP, SEXP rSEXP, SEXP tolerateSEXP) {
+List panel_factor_ub(const arma::mat& E, const arma::mat& I, int r, double tolerate, int svd_method, int oversample, int power, int accel, Rcpp::Nullable<Rcpp::List> control);
+RcppExport SEXP _gsynth_panel_factor_ub(SEXP ESEXP, SEXP ISEXP, SEXP rSEXP, SEXP tolerateSEXP, SEXP svd_methodSEXP, SEXP oversampleSEXP, SEXP powerSEXP, SEXP accelSEXP, SEXP controlSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< arma::mat >::type E(ESEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type I(ISEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type E(ESEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type I(ISEXP);
     Rcpp::traits::input_parameter< int >::type r(rSEXP);
     Rcpp::traits::input_parameter< double >::type tolerate(tolerateSEXP);
-    rcpp_result_gen = Rcpp::wrap(panel_factor_ub(E, I, r, tolerate));
+    Rcpp::traits::input_parameter< int >::type svd_method(svd_methodSEXP);
+    Rcpp::traits::input_parameter< int >::type oversample(oversampleSEXP);
+    Rcpp::traits::input_parameter< int >::type power(powerSEXP);
+    Rcpp::traits::input_parameter< int >::type accel(accelSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::List> >::type control(controlSEXP);
+    rcpp_result_gen = Rcpp::wrap(panel_factor_ub(E, I, r, tolerate, svd_method, oversample, power, accel, control));
     return rcpp_result_gen;
 END_RCPP
 }
 // panel_FE
-arma::mat panel_FE(arma::mat E, double lambda);
-RcppExport SEXP _gsynth_panel_FE(SEXP ESEXP, SEXP lambdaSEXP) {
+arma::mat panel_FE(const arma::mat& E, double lambda, int svd_method);
+RcppExport SEXP _gsynth_panel_FE(SEXP ESEXP, SEXP lambdaSEXP, SEXP svd_methodSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< arma::mat >::type E(ESEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type E(ESEXP);
     Rcpp::traits::input_parameter< double >::type lambda(lambdaSEXP);
-    rcpp_result_gen = Rcpp::wrap(panel_FE(E, lambda));
+    Rcpp::traits::input_parameter< int >::type svd_method(svd_methodSEXP);
+    rcpp_result_gen = Rcpp::wrap(panel_FE(E, lambda, svd_method));
     return rcpp_result_gen;
 END_RCPP
 }
 // panel_FE_ub
-List panel_FE_ub(arma::mat E, arma::mat I, double lambda, double tolerate);
-RcppExport SEXP _gsynth_panel_FE_ub(SEXP ESEXP, SEXP ISEXP, SEXP lambdaSEXP, SEXP tolerateSEXP) {
+List panel_FE_ub(const arma::mat& E, const arma::mat& I, double lambda, double tolerate, int accel, int svd_method);
+RcppExport SEXP _gsynth_panel_FE_ub(SEXP ESEXP, SEXP ISEXP, SEXP lambdaSEXP, SEXP tolerateSEXP, SEXP accelSEXP, SEXP svd_methodSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< arma::mat >::type E(ESEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type I(ISEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type E(ESEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type I(ISEXP);
     Rcpp::traits::input_parameter< double >::type lambda(lambdaSEXP);
     Rcpp::traits::input_parameter< double >::type tolerate(tolerateSEXP);
-    rcpp_result_gen = Rcpp::wrap(panel_FE_ub(E, I, lambda, tolerate));
+    Rcpp::traits::input_parameter< int >::type accel(accelSEXP);
+    Rcpp::traits::input_parameter< int >::type svd_method(svd_methodSEXP);
+    rcpp_result_gen = Rcpp::wrap(panel_FE_ub(E, I, lambda, tolerate, accel, svd_method));
     return rcpp_result_gen;
 END_RCPP
 }
 // fe_ad_iter
-List fe_ad_iter(arma::mat Y, arma::mat I, int force, double tolerate);
-RcppExport SEXP _gsynth_fe_ad_iter(SEXP YSEXP, SEXP ISEXP, SEXP forceSEXP, SEXP tolerateSEXP) {
+List fe_ad_iter(const arma::mat& Y, const arma::mat& I, int force, double tolerate, int accel);
+RcppExport SEXP _gsynth_fe_ad_iter(SEXP YSEXP, SEXP ISEXP, SEXP forceSEXP, SEXP tolerateSEXP, SEXP accelSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< arma::mat >::type Y(YSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type I(ISEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type I(ISEXP);
     Rcpp::traits::input_parameter< int >::type force(forceSEXP);
     Rcpp::traits::input_parameter< double >::type tolerate(tolerateSEXP);
-    rcpp_result_gen = Rcpp::wrap(fe_ad_iter(Y, I, force, tolerate));
+    Rcpp::traits::input_parameter< int >::type accel(accelSEXP);
+    rcpp_result_gen = Rcpp::wrap(fe_ad_iter(Y, I, force, tolerate, accel));
     return rcpp_result_gen;
 END_RCPP
 }
 // fe_ad_covar_iter
-List fe_ad_covar_iter(arma::cube XX, arma::mat xxinv, arma::mat alpha_X, arma::mat xi_X, arma::mat mu_X, arma::mat Y, arma::mat I, int force, double tolerate);
-RcppExport SEXP _gsynth_fe_ad_covar_iter(SEXP XXSEXP, SEXP xxinvSEXP, SEXP alpha_XSEXP, SEXP xi_XSEXP, SEXP mu_XSEXP, SEXP YSEXP, SEXP ISEXP, SEXP forceSEXP, SEXP tolerateSEXP) {
+List fe_ad_covar_iter(const arma::cube& XX, const arma::mat& xxinv, const arma::mat& alpha_X, const arma::mat& xi_X, const arma::mat& mu_X, const arma::mat& Y, const arma::mat& I, int force, double tolerate, int accel, Rcpp::Nullable<Rcpp::List> control);
+RcppExport SEXP _gsynth_fe_ad_covar_iter(SEXP XXSEXP, SEXP xxinvSEXP, SEXP alpha_XSEXP, SEXP xi_XSEXP, SEXP mu_XSEXP, SEXP YSEXP, SEXP ISEXP, SEXP forceSEXP, SEXP tolerateSEXP, SEXP accelSEXP, SEXP controlSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< arma::cube >::type XX(XXSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type xxinv(xxinvSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type alpha_X(alpha_XSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type xi_X(xi_XSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type mu_X(mu_XSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type Y(YSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type I(ISEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type XX(XXSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type xxinv(xxinvSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type alpha_X(alpha_XSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type xi_X(xi_XSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type mu_X(mu_XSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type I(ISEXP);
     Rcpp::traits::input_parameter< int >::type force(forceSEXP);
     Rcpp::traits::input_parameter< double >::type tolerate(tolerateSEXP);
-    rcpp_result_gen = Rcpp::wrap(fe_ad_covar_iter(XX, xxinv, alpha_X, xi_X, mu_X, Y, I, force, tolerate));
+    Rcpp::traits::input_parameter< int >::type accel(accelSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::List> >::type control(controlSEXP);
+    rcpp_result_gen = Rcpp::wrap(fe_ad_covar_iter(XX, xxinv, alpha_X, xi_X, mu_X, Y, I, force, tolerate, accel, control));
     return rcpp_result_gen;
 END_RCPP
 }
 // fe_ad_inter_iter
-List fe_ad_inter_iter(arma::mat Y, arma::mat I, int force, int mc, int r, double lambda, double tolerate);
-RcppExport SEXP _gsynth_fe_ad_inter_iter(SEXP YSEXP, SEXP ISEXP, SEXP forceSEXP, SEXP mcSEXP, SEXP rSEXP, SEXP lambdaSEXP, SEXP tolerateSEXP) {
+List fe_ad_inter_iter(const arma::mat& Y, const arma::mat& I, int force, int mc, int r, double lambda, double tolerate, const arma::mat& factor0, int svd_method, int oversample, int power, int accel, Rcpp::Nullable<Rcpp::List> control);
+RcppExport SEXP _gsynth_fe_ad_inter_iter(SEXP YSEXP, SEXP ISEXP, SEXP forceSEXP, SEXP mcSEXP, SEXP rSEXP, SEXP lambdaSEXP, SEXP tolerateSEXP, SEXP factor0SEXP, SEXP svd_methodSEXP, SEXP oversampleSEXP, SEXP powerSEXP, SEXP accelSEXP, SEXP controlSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< arma::mat >::type Y(YSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type I(ISEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type I(ISEXP);
     Rcpp::traits::input_parameter< int >::type force(forceSEXP);
     Rcpp::traits::input_parameter< int >::type mc(mcSEXP);
     Rcpp::traits::input_parameter< int >::type r(rSEXP);
     Rcpp::traits::input_parameter< double >::type lambda(lambdaSEXP);
     Rcpp::traits::input_parameter< double >::type tolerate(tolerateSEXP);
-    rcpp_result_gen = Rcpp::wrap(fe_ad_inter_iter(Y, I, force, mc, r, lambda, tolerate));
+    Rcpp::traits::input_parameter< const arma::mat& >::type factor0(factor0SEXP);
+    Rcpp::traits::input_parameter< int >::type svd_method(svd_methodSEXP);
+    Rcpp::traits::input_parameter< int >::type oversample(oversampleSEXP);
+    Rcpp::traits::input_parameter< int >::type power(powerSEXP);
+    Rcpp::traits::input_parameter< int >::type accel(accelSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::List> >::type control(controlSEXP);
+    rcpp_result_gen = Rcpp::wrap(fe_ad_inter_iter(Y, I, force, mc, r, lambda, tolerate, factor0, svd_method, oversample, power, accel, control));
     return rcpp_result_gen;
 END_RCPP
 }
 // fe_ad_inter_covar_iter
-List fe_ad_inter_covar_iter(arma::cube XX, arma::mat xxinv, arma::mat alpha_X, arma::mat xi_X, arma::mat mu_X, arma::mat Y, arma::mat I, int force, int mc, int r, double lambda, double tolerate);
-RcppExport SEXP _gsynth_fe_ad_inter_covar_iter(SEXP XXSEXP, SEXP xxinvSEXP, SEXP alpha_XSEXP, SEXP xi_XSEXP, SEXP mu_XSEXP, SEXP YSEXP, SEXP ISEXP, SEXP forceSEXP, SEXP mcSEXP, SEXP rSEXP, SEXP lambdaSEXP, SEXP tolerateSEXP) {
+List fe_ad_inter_covar_iter(const arma::cube& XX, const arma::mat& xxinv, const arma::mat& alpha_X, const arma::mat& xi_X, const arma::mat& mu_X, const arma::mat& Y, const arma::mat& I, int force, int mc, int r, double lambda, double tolerate, const arma::mat& factor0, int svd_method, int oversample, int power, int accel);
+RcppExport SEXP _gsynth_fe_ad_inter_covar_iter(SEXP XXSEXP, SEXP xxinvSEXP, SEXP alpha_XSEXP, SEXP xi_XSEXP, SEXP mu_XSEXP, SEXP YSEXP, SEXP ISEXP, SEXP forceSEXP, SEXP mcSEXP, SEXP rSEXP, SEXP lambdaSEXP, SEXP tolerateSEXP, SEXP factor0SEXP, SEXP svd_methodSEXP, SEXP oversampleSEXP, SEXP powerSEXP, SEXP accelSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< arma::cube >::type XX(XXSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type xxinv(xxinvSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type alpha_X(alpha_XSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type xi_X(xi_XSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type mu_X(mu_XSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type Y(YSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type I(ISEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type XX(XXSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type xxinv(xxinvSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type alpha_X(alpha_XSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type xi_X(xi_XSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type mu_X(mu_XSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type I(ISEXP);
     Rcpp::traits::input_parameter< int >::type force(forceSEXP);
     Rcpp::traits::input_parameter< int >::type mc(mcSEXP);
     Rcpp::traits::input_parameter< int >::type r(rSEXP);
     Rcpp::traits::input_parameter< double >::type lambda(lambdaSEXP);
     Rcpp::traits::input_parameter< double >::type tolerate(tolerateSEXP);
-    rcpp_result_gen = Rcpp::wrap(fe_ad_inter_covar_iter(XX, xxinv, alpha_X, xi_X, mu_X, Y, I, force, mc, r, lambda, tolerate));
+    Rcpp::traits::input_parameter< const arma::mat& >::type factor0(factor0SEXP);
+    Rcpp::traits::input_parameter< int >::type svd_method(svd_methodSEXP);
+    Rcpp::traits::input_parameter< int >::type oversample(oversampleSEXP);
+    Rcpp::traits::input_parameter< int >::type power(powerSEXP);
+    Rcpp::traits::input_parameter< int >::type accel(accelSEXP);
+    rcpp_result_gen = Rcpp::wrap(fe_ad_inter_covar_iter(XX, xxinv, alpha_X, xi_X, mu_X, Y, I, force, mc, r, lambda, tolerate, factor0, svd_method, oversample, power, accel));
     return rcpp_result_gen;
 END_RCPP
 }
 // beta_iter
-List beta_iter(arma::cube X, arma::mat xxinv, arma::mat Y, int r, double tolerate, arma::mat beta0);
-RcppExport SEXP _gsynth_beta_iter(SEXP XSEXP, SEXP xxinvSEXP, SEXP YSEXP, SEXP rSEXP, SEXP tolerateSEXP, SEXP beta0SEXP) {
+List beta_iter(const arma::cube& X, const arma::mat& xxinv, const arma::mat& Y, int r, double tolerate, const arma::mat& beta0, const arma::mat& factor0, int svd_method, int oversample, int power, int accel, Rcpp::Nullable<Rcpp::List> control);
+RcppExport SEXP _gsynth_beta_iter(SEXP XSEXP, SEXP xxinvSEXP, SEXP YSEXP, SEXP rSEXP, SEXP tolerateSEXP, SEXP beta0SEXP, SEXP factor0SEXP, SEXP svd_methodSEXP, SEXP oversampleSEXP, SEXP powerSEXP, SEXP accelSEXP, SEXP controlSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< arma::cube >::type X(XSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type xxinv(xxinvSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type xxinv(xxinvSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type Y(YSEXP);
     Rcpp::traits::input_parameter< int >::type r(rSEXP);
     Rcpp::traits::input_parameter< double >::type tolerate(tolerateSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type beta0(beta0SEXP);
-    rcpp_result_gen = Rcpp::wrap(beta_iter(X, xxinv, Y, r, tolerate, beta0));
+    Rcpp::traits::input_parameter< const arma::mat& >::type beta0(beta0SEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type factor0(factor0SEXP);
+    Rcpp::traits::input_parameter< int >::type svd_method(svd_methodSEXP);
+    Rcpp::traits::input_parameter< int >::type oversample(oversampleSEXP);
+    Rcpp::traits::input_parameter< int >::type power(powerSEXP);
+    Rcpp::traits::input_parameter< int >::type accel(accelSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::List> >::type control(controlSEXP);
+    rcpp_result_gen = Rcpp::wrap(beta_iter(X, xxinv, Y, r, tolerate, beta0, factor0, svd_method, oversample, power, accel, control));
     return rcpp_result_gen;
 END_RCPP
 }
 // beta_iter_ub
-List beta_iter_ub(arma::cube X, arma::mat xxinv, arma::mat Y, arma::mat I, int r, double tolerate, arma::mat beta0);
-RcppExport SEXP _gsynth_beta_iter_ub(SEXP XSEXP, SEXP xxinvSEXP, SEXP YSEXP, SEXP ISEXP, SEXP rSEXP, SEXP tolerateSEXP, SEXP beta0SEXP) {
+List beta_iter_ub(const arma::cube& X, const arma::mat& xxinv, const arma::mat& Y, const arma::mat& I, int r, double tolerate, const arma::mat& beta0, int svd_method, int oversample, int power);
+RcppExport SEXP _gsynth_beta_iter_ub(SEXP XSEXP, SEXP xxinvSEXP, SEXP YSEXP, SEXP ISEXP, SEXP rSEXP, SEXP tolerateSEXP, SEXP beta0SEXP, SEXP svd_methodSEXP, SEXP oversampleSEXP, SEXP powerSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< arma::cube >::type X(XSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type xxinv(xxinvSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type Y(YSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type I(ISEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type xxinv(xxinvSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type I(ISEXP);
     Rcpp::traits::input_parameter< int >::type r(rSEXP);
     Rcpp::traits::input_parameter< double >::type tolerate(tolerateSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type beta0(beta0SEXP);
-    rcpp_result_gen = Rcpp::wrap(beta_iter_ub(X, xxinv, Y, I, r, tolerate, beta0));
+    Rcpp::traits::input_parameter< const arma::mat& >::type beta0(beta0SEXP);
+    Rcpp::traits::input_parameter< int >::type svd_method(svd_methodSEXP);
+    Rcpp::traits::input_parameter< int >::type oversample(oversampleSEXP);
+    Rcpp::traits::input_parameter< int >::type power(powerSEXP);
+    rcpp_result_gen = Rcpp::wrap(beta_iter_ub(X, xxinv, Y, I, r, tolerate, beta0, svd_method, oversample, power));
     return rcpp_result_gen;
 END_RCPP
 }
 // inter_fe
-List inter_fe(arma::mat Y, arma::cube X, int r, int force, arma::mat beta0, double tol);
-RcppExport SEXP _gsynth_inter_fe(SEXP YSEXP, SEXP XSEXP, SEXP rSEXP, SEXP forceSEXP, SEXP beta0SEXP, SEXP tolSEXP) {
+List inter_fe(const arma::mat& Y, const arma::cube& X, int r, int force, const arma::mat& beta0, double tol, int svd_method, int oversample, int power, int precision, Rcpp::Nullable<Rcpp::NumericMatrix> factor0, Rcpp::Nullable<Rcpp::List> control);
+RcppExport SEXP _gsynth_inter_fe(SEXP YSEXP, SEXP XSEXP, SEXP rSEXP, SEXP forceSEXP, SEXP beta0SEXP, SEXP tolSEXP, SEXP svd_methodSEXP, SEXP oversampleSEXP, SEXP powerSEXP, SEXP precisionSEXP, SEXP factor0SEXP, SEXP controlSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< arma::mat >::type Y(YSEXP);
-    Rcpp::traits::input_parameter< arma::cube >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type X(XSEXP);
     Rcpp::traits::input_parameter< int >::type r(rSEXP);
     Rcpp::traits::input_parameter< int >::type force(forceSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type beta0(beta0SEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type beta0(beta0SEXP);
     Rcpp::traits::input_parameter< double >::type tol(tolSEXP);
-    rcpp_result_gen = Rcpp::wrap(inter_fe(Y, X, r, force, beta0, tol));
+    Rcpp::traits::input_parameter< int >::type svd_method(svd_methodSEXP);
+    Rcpp::traits::input_parameter< int >::type oversample(oversampleSEXP);
+    Rcpp::traits::input_parameter< int >::type power(powerSEXP);
+    Rcpp::traits::input_parameter< int >::type precision(precisionSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::NumericMatrix> >::type factor0(factor0SEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::List> >::type control(controlSEXP);
+    rcpp_result_gen = Rcpp::wrap(inter_fe(Y, X, r, force, beta0, tol, svd_method, oversample, power, precision, factor0, control));
     return rcpp_result_gen;
 END_RCPP
 }
 // inter_fe_ub
-List inter_fe_ub(arma::mat Y, arma::cube X, arma::mat I, int r, int force, double tol);
-RcppExport SEXP _gsynth_inter_fe_ub(SEXP YSEXP, SEXP XSEXP, SEXP ISEXP, SEXP rSEXP, SEXP forceSEXP, SEXP tolSEXP) {
+List inter_fe_ub(const arma::mat& Y, const arma::cube& X, const arma::mat& I, int r, int force, double tol, int svd_method, int oversample, int power, int precision, Rcpp::Nullable<Rcpp::NumericMatrix> factor0, Rcpp::Nullable<Rcpp::List> control);
+RcppExport SEXP _gsynth_inter_fe_ub(SEXP YSEXP, SEXP XSEXP, SEXP ISEXP, SEXP rSEXP, SEXP forceSEXP, SEXP tolSEXP, SEXP svd_methodSEXP, SEXP oversampleSEXP, SEXP powerSEXP, SEXP precisionSEXP, SEXP factor0SEXP, SEXP controlSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< arma::mat >::type Y(YSEXP);
-    Rcpp::traits::input_parameter< arma::cube >::type X(XSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type I(ISEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type I(ISEXP);
     Rcpp::traits::input_parameter< int >::type r(rSEXP);
     Rcpp::traits::input_parameter< int >::type force(forceSEXP);
     Rcpp::traits::input_parameter< double >::type tol(tolSEXP);
-    rcpp_result_gen = Rcpp::wrap(inter_fe_ub(Y, X, I, r, force, tol));
+    Rcpp::traits::input_parameter< int >::type svd_method(svd_methodSEXP);
+    Rcpp::traits::input_parameter< int >::type oversample(oversampleSEXP);
+    Rcpp::traits::input_parameter< int >::type power(powerSEXP);
+    Rcpp::traits::input_parameter< int >::type precision(precisionSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::NumericMatrix> >::type factor0(factor0SEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::List> >::type control(controlSEXP);
+    rcpp_result_gen = Rcpp::wrap(inter_fe_ub(Y, X, I, r, force, tol, svd_method, oversample, power, precision, factor0, control));
+    return rcpp_result_gen;
+END_RCPP
+}
+// inter_fe_path
+List inter_fe_path(const arma::mat& Y, const arma::cube& X, const arma::mat& I, int r_min, int r_max, int force, const arma::mat& beta0, double tol, int precision);
+RcppExport SEXP _gsynth_inter_fe_path(SEXP YSEXP, SEXP XSEXP, SEXP ISEXP, SEXP r_minSEXP, SEXP r_maxSEXP, SEXP forceSEXP, SEXP beta0SEXP, SEXP tolSEXP, SEXP precisionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::mat& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type I(ISEXP);
+    Rcpp::traits::input_parameter< int >::type r_min(r_minSEXP);
+    Rcpp::traits::input_parameter< int >::type r_max(r_maxSEXP);
+    Rcpp::traits::input_parameter< int >::type force(forceSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type beta0(beta0SEXP);
+    Rcpp::traits::input_parameter< double >::type tol(tolSEXP);
+    Rcpp::traits::input_parameter< int >::type precision(precisionSEXP);
+    rcpp_result_gen = Rcpp::wrap(inter_fe_path(Y, X, I, r_min, r_max, force, beta0, tol, precision));
+    return rcpp_result_gen;
+END_RCPP
+}
+// inter_fe_multi
+List inter_fe_multi(const arma::cube& Y, const arma::cube& X, const arma::mat& I, int r, int force, const arma::mat& beta0, double tol, int precision, int cores);
+RcppExport SEXP _gsynth_inter_fe_multi(SEXP YSEXP, SEXP XSEXP, SEXP ISEXP, SEXP rSEXP, SEXP forceSEXP, SEXP beta0SEXP, SEXP tolSEXP, SEXP precisionSEXP, SEXP coresSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::cube& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type I(ISEXP);
+    Rcpp::traits::input_parameter< int >::type r(rSEXP);
+    Rcpp::traits::input_parameter< int >::type force(forceSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type beta0(beta0SEXP);
+    Rcpp::traits::input_parameter< double >::type tol(tolSEXP);
+    Rcpp::traits::input_parameter< int >::type precision(precisionSEXP);
+    Rcpp::traits::input_parameter< int >::type cores(coresSEXP);
+    rcpp_result_gen = Rcpp::wrap(inter_fe_multi(Y, X, I, r, force, beta0, tol, precision, cores));
     return rcpp_result_gen;
 END_RCPP
 }
 // inter_fe_mc
-List inter_fe_mc(arma::mat Y, arma::cube X, arma::mat I, int r, double lambda, int force, double tol);
-RcppExport SEXP _gsynth_inter_fe_mc(SEXP YSEXP, SEXP XSEXP, SEXP ISEXP, SEXP rSEXP, SEXP lambdaSEXP, SEXP forceSEXP, SEXP tolSEXP) {
+List inter_fe_mc(const arma::mat& Y, const arma::cube& X, const arma::mat& I, int r, double lambda, int force, double tol, Rcpp::Nullable<Rcpp::List> control);
+RcppExport SEXP _gsynth_inter_fe_mc(SEXP YSEXP, SEXP XSEXP, SEXP ISEXP, SEXP rSEXP, SEXP lambdaSEXP, SEXP forceSEXP, SEXP tolSEXP, SEXP controlSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< arma::mat >::type Y(YSEXP);
-    Rcpp::traits::input_parameter< arma::cube >::type X(XSEXP);
-    Rcpp::traits::input_parameter< arma::mat >::type I(ISEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type I(ISEXP);
     Rcpp::traits::input_parameter< int >::type r(rSEXP);
     Rcpp::traits::input_parameter< double >::type lambda(lambdaSEXP);
     Rcpp::traits::input_parameter< int >::type force(forceSEXP);
     Rcpp::traits::input_parameter< double >::type tol(tolSEXP);
-    rcpp_result_gen = Rcpp::wrap(inter_fe_mc(Y, X, I, r, lambda, force, tol));
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::List> >::type control(controlSEXP);
+    rcpp_result_gen = Rcpp::wrap(inter_fe_mc(Y, X, I, r, lambda, force, tol, control));
+    return rcpp_result_gen;
+END_RCPP
+}
+// inter_fe_mc_path
+List inter_fe_mc_path(const arma::mat& Y, const arma::cube& X, const arma::mat& I, int r, const arma::vec& lambda, int force, double tol);
+RcppExport SEXP _gsynth_inter_fe_mc_path(SEXP YSEXP, SEXP XSEXP, SEXP ISEXP, SEXP rSEXP, SEXP lambdaSEXP, SEXP forceSEXP, SEXP tolSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::mat& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type I(ISEXP);
+    Rcpp::traits::input_parameter< int >::type r(rSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type lambda(lambdaSEXP);
+    Rcpp::traits::input_parameter< int >::type force(forceSEXP);
+    Rcpp::traits::input_parameter< double >::type tol(tolSEXP);
+    rcpp_result_gen = Rcpp::wrap(inter_fe_mc_path(Y, X, I, r, lambda, force, tol));
+    return rcpp_result_gen;
+END_RCPP
+}
+// panel_wide
+List panel_wide(const IntegerVector& id, const IntegerVector& time, const arma::mat& data, int N, int T);
+RcppExport SEXP _gsynth_panel_wide(SEXP idSEXP, SEXP timeSEXP, SEXP dataSEXP, SEXP NSEXP, SEXP TSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const IntegerVector& >::type id(idSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type time(timeSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type data(dataSEXP);
+    Rcpp::traits::input_parameter< int >::type N(NSEXP);
+    Rcpp::traits::input_parameter< int >::type T(TSEXP);
+    rcpp_result_gen = Rcpp::wrap(panel_wide(id, time, data, N, T));
+    return rcpp_result_gen;
+END_RCPP
+}
+// treat_index
+List treat_index(arma::mat D, const arma::mat& I, int absorb);
+RcppExport SEXP _gsynth_treat_index(SEXP DSEXP, SEXP ISEXP, SEXP absorbSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< arma::mat >::type D(DSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type I(ISEXP);
+    Rcpp::traits::input_parameter< int >::type absorb(absorbSEXP);
+    rcpp_result_gen = Rcpp::wrap(treat_index(D, I, absorb));
     return rcpp_result_gen;
 END_RCPP
 }
 
 static const R_CallMethodDef CallEntries[] = {
+    {"_gsynth_boot_inter_fe", (DL_FUNC) &_gsynth_boot_inter_fe, 11},
+    {"_gsynth_psd_factor", (DL_FUNC) &_gsynth_psd_factor, 1},
+    {"_gsynth_mvn_draw", (DL_FUNC) &_gsynth_mvn_draw, 4},
+    {"_gsynth_mvn_draw_units", (DL_FUNC) &_gsynth_mvn_draw_units, 3},
+    {"_gsynth_res_vcov", (DL_FUNC) &_gsynth_res_vcov, 2},
+    {"_gsynth_cv_mc", (DL_FUNC) &_gsynth_cv_mc, 9},
+    {"_gsynth_loo_mspe", (DL_FUNC) &_gsynth_loo_mspe, 3},
+    {"_gsynth_synth_em", (DL_FUNC) &_gsynth_synth_em, 14},
+    {"_gsynth_set_thread_cap", (DL_FUNC) &_gsynth_set_thread_cap, 1},
+    {"_gsynth_arma_alloc_count", (DL_FUNC) &_gsynth_arma_alloc_count, 0},
     {"_gsynth_data_ub_adj", (DL_FUNC) &_gsynth_data_ub_adj, 2},
     {"_gsynth_XXinv", (DL_FUNC) &_gsynth_XXinv, 1},
     {"_gsynth_Y_demean", (DL_FUNC) &_gsynth_Y_demean, 2},
@@ -320,19 +608,24 @@ static const R_CallMethodDef CallEntries[] = {
     {"_gsynth_fe_add2", (DL_FUNC) &_gsynth_fe_add2, 6},
     {"_gsynth_panel_est", (DL_FUNC) &_gsynth_panel_est, 3},
     {"_gsynth_panel_beta", (DL_FUNC) &_gsynth_panel_beta, 4},
-    {"_gsynth_panel_factor", (DL_FUNC) &_gsynth_panel_factor, 2},
-    {"_gsynth_panel_factor_ub", (DL_FUNC) &_gsynth_panel_factor_ub, 4},
-    {"_gsynth_panel_FE", (DL_FUNC) &_gsynth_panel_FE, 2},
-    {"_gsynth_panel_FE_ub", (DL_FUNC) &_gsynth_panel_FE_ub, 4},
-    {"_gsynth_fe_ad_iter", (DL_FUNC) &_gsynth_fe_ad_iter, 4},
-    {"_gsynth_fe_ad_covar_iter", (DL_FUNC) &_gsynth_fe_ad_covar_iter, 9},
-    {"_gsynth_fe_ad_inter_iter", (DL_FUNC) &_gsynth_fe_ad_inter_iter, 7},
-    {"_gsynth_fe_ad_inter_covar_iter", (DL_FUNC) &_gsynth_fe_ad_inter_covar_iter, 12},
-    {"_gsynth_beta_iter", (DL_FUNC) &_gsynth_beta_iter, 6},
-    {"_gsynth_beta_iter_ub", (DL_FUNC) &_gsynth_beta_iter_ub, 7},
-    {"_gsynth_inter_fe", (DL_FUNC) &_gsynth_inter_fe, 6},
-    {"_gsynth_inter_fe_ub", (DL_FUNC) &_gsynth_inter_fe_ub, 6},
-    {"_gsynth_inter_fe_mc", (DL_FUNC) &_gsynth_inter_fe_mc, 7},
+    {"_gsynth_panel_factor", (DL_FUNC) &_gsynth_panel_factor, 5},
+    {"_gsynth_panel_factor_ub", (DL_FUNC) &_gsynth_panel_factor_ub, 9},
+    {"_gsynth_panel_FE", (DL_FUNC) &_gsynth_panel_FE, 3},
+    {"_gsynth_panel_FE_ub", (DL_FUNC) &_gsynth_panel_FE_ub, 6},
+    {"_gsynth_fe_ad_iter", (DL_FUNC) &_gsynth_fe_ad_iter, 5},
+    {"_gsynth_fe_ad_covar_iter", (DL_FUNC) &_gsynth_fe_ad_covar_iter, 11},
+    {"_gsynth_fe_ad_inter_iter", (DL_FUNC) &_gsynth_fe_ad_inter_iter, 13},
+    {"_gsynth_fe_ad_inter_covar_iter", (DL_FUNC) &_gsynth_fe_ad_inter_covar_iter, 17},
+    {"_gsynth_beta_iter", (DL_FUNC) &_gsynth_beta_iter, 12},
+    {"_gsynth_beta_iter_ub", (DL_FUNC) &_gsynth_beta_iter_ub, 10},
+    {"_gsynth_inter_fe", (DL_FUNC) &_gsynth_inter_fe, 12},
+    {"_gsynth_inter_fe_ub", (DL_FUNC) &_gsynth_inter_fe_ub, 12},
+    {"_gsynth_inter_fe_path", (DL_FUNC) &_gsynth_inter_fe_path, 9},
+    {"_gsynth_inter_fe_multi", (DL_FUNC) &_gsynth_inter_fe_multi, 9},
+    {"_gsynth_inter_fe_mc", (DL_FUNC) &_gsynth_inter_fe_mc, 8},
+    {"_gsynth_inter_fe_mc_path", (DL_FUNC) &_gsynth_inter_fe_mc_path, 7},
+    {"_gsynth_panel_wide", (DL_FUNC) &_gsynth_panel_wide, 5},
+    {"_gsynth_treat_index", (DL_FUNC) &_gsynth_treat_index, 3},
     {NULL, NULL, 0}
 };
 
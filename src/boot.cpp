@@ -0,0 +1,192 @@
+# include "gsynth_types.h"
+# include <RcppArmadillo.h>
+# include <random>
+# ifdef _OPENMP
+# include <omp.h>
+# endif
+# include "interFE.h"
+// [[Rcpp::depends(RcppArmadillo)]]
+// [[Rcpp::plugins(cpp11)]]
+// [[Rcpp::plugins(openmp)]]
+
+using namespace Rcpp ;
+
+/* ******************* Bootstrap  *********************** */
+
+/* Replicates are independent fits on read-only data, so they run on an
+   OpenMP thread team. Nothing inside the parallel region touches the R
+   API: the panel is converted once, the fits use the native cores and
+   every replicate draws its units from its own generator, seeded by
+   (seed, b). The draws are therefore the same for any number of
+   threads. Armadillo's warnings are compiled out (ARMA_WARN_LEVEL=0,
+   see Makevars) and failed fits are caught in the thread, so workers
+   never write to the R console. */
+
+/* unit indices of bootstrap replicate b */
+arma::uvec boot_units (int N, int b, int seed) {
+  std::seed_seq seq{(unsigned int) seed, (unsigned int) b} ;
+  std::mt19937_64 gen(seq) ;
+  std::uniform_int_distribution<int> unit(0, N - 1) ;
+  arma::uvec smp(N) ;
+  for (int i = 0; i < N; i++) {
+    smp(i) = unit(gen) ;
+  }
+  return(smp) ;
+}
+
+/* nonparametric bootstrap of inter_fe / inter_fe_ub over units:
+   (beta', mu) of each replicate, NaN for replicates that failed */
+// [[Rcpp::export]]
+arma::mat boot_inter_fe (const arma::mat& Y,
+                         const arma::cube& X,
+                         const arma::mat& I,
+                         int r,
+                         int force,
+                         const arma::mat& beta0,
+                         int nboots,
+                         int seed,
+                         double tol = 1e-5,
+                         int cores = 1,
+                         int precision = 0 // 1: factor extraction in single precision
+                         ) {
+  int N = Y.n_cols ;
+  int p = X.n_slices ;
+  int ub = arma::any(arma::vectorise(I) == 0) ; // unbalanced panel
+  FactorEngine engine = {0, 10, 2, precision} ;
+  IterControl ctl = iter_control(tol) ;
+
+  arma::mat est(nboots, p + 1) ;
+  est.fill(arma::datum::nan) ;
+
+  int nthreads = thread_count(cores) ;
+  #pragma omp parallel for num_threads(nthreads) schedule(dynamic) if(nthreads > 1)
+  for (int b = 0; b < nboots; b++) {
+    try {
+      // the estimators read the shared panel through the unit index
+      arma::uvec smp = boot_units(N, b, seed) ;
+      InterFit fit ;
+      if (ub == 0) {
+        fit = inter_fe_core(Y, X, r, force, beta0, ctl, engine,
+                            arma::mat(), smp) ;
+      } else {
+        fit = inter_fe_ub_core(Y, X, I, r, force, ctl, engine,
+                               arma::mat(), smp) ;
+      }
+      for (int k = 0; k < p; k++) {
+        est(b, k) = fit.beta(k) ;
+      }
+      est(b, p) = fit.mu ;
+    } catch (...) {
+      // leave the row as NaN; exceptions must not leave the thread
+    }
+  }
+
+  return(est) ;
+}
+
+/* ******************* Parametric Errors  *********************** */
+
+/* The parametric bootstrap draws gaussian error paths with the
+   covariance of the residuals. Each covariance is factorized once and
+   the draws of many paths are one matrix product L * Z. Z comes from a
+   generator seeded by (seed, kind, index): kind 0 is the treated unit
+   index, kind 1 the replicate. The draws therefore do not depend on
+   the order or the worker in which replicates run. The seed itself is
+   drawn from R's RNG by the caller. */
+
+/* T * n standard normals of stream (seed, kind, index) */
+arma::mat gauss_matrix (int T, int n, int seed, int kind, int index) {
+  std::seed_seq seq{(unsigned int) seed, (unsigned int) kind,
+                    (unsigned int) index} ;
+  std::mt19937_64 gen(seq) ;
+  std::normal_distribution<double> gauss(0.0, 1.0) ;
+  arma::mat Z(T, n) ;
+  for (arma::uword k = 0; k < Z.n_elem; k++) {
+    Z(k) = gauss(gen) ;
+  }
+  return(Z) ;
+}
+
+/* L with S = L * L': lower cholesky factor, or, when S is only
+   positive semi-definite (as banded or sparsely observed residual
+   covariances often are), V * diag(sqrt(max(d, 0))) from its eigen
+   decomposition */
+// [[Rcpp::export]]
+arma::mat psd_factor (const arma::mat& S) {
+  arma::mat L ;
+  if (arma::chol(L, S, "lower")) {
+    return(L) ;
+  }
+  arma::vec d ;
+  arma::mat V ;
+  if (!arma::eig_sym(d, V, arma::symmatu(S))) {
+    Rcpp::stop("cannot factorize the error covariance.") ;
+  }
+  for (arma::uword k = 0; k < d.n_elem; k++) {
+    V.col(k) *= d(k) > 0 ? sqrt(d(k)) : 0.0 ;
+  }
+  return(V) ;
+}
+
+/* n gaussian paths (T * n) with covariance L * L', stream (seed, 1, b):
+   the errors of bootstrap replicate b */
+// [[Rcpp::export]]
+arma::mat mvn_draw (const arma::mat& L,
+                    int n,
+                    int seed,
+                    int b
+                    ) {
+  return(L * gauss_matrix(L.n_cols, n, seed, 1, b)) ;
+}
+
+/* errors of the treated units for all replicates: T * Ntr * nboots,
+   path b of unit w with covariance Sigma(, , w); one factorization and
+   one product per unit */
+// [[Rcpp::export]]
+arma::cube mvn_draw_units (const arma::cube& Sigma,
+                           int nboots,
+                           int seed
+                           ) {
+  int T = Sigma.n_rows ;
+  int Ntr = Sigma.n_slices ;
+  arma::cube E(T, Ntr, nboots) ;
+  for (int w = 0; w < Ntr; w++) {
+    arma::mat L = psd_factor(Sigma.slice(w)) ;
+    arma::mat Ew = L * gauss_matrix(T, nboots, seed, 0, w) ; // T * nboots
+    for (int b = 0; b < nboots; b++) {
+      E.slice(b).col(w) = Ew.col(b) ;
+    }
+  }
+  return(E) ;
+}
+
+/* covariance of residual paths res (T * n, NaN where missing) within
+   cov_ar periods: entry (s, t), |s - t| <= cov_ar, is the sum of
+   res(s, ) res(t, ) over the paths observed at both, divided by their
+   number (by 1 if there are none); 0 outside the band. O(T cov_ar n) */
+// [[Rcpp::export]]
+arma::mat res_vcov (const arma::mat& res,
+                    int cov_ar = 1
+                    ) {
+  int T = res.n_rows ;
+  int n = res.n_cols ;
+  arma::mat R = res.t() ; // a period per column
+  arma::mat V(T, T, arma::fill::zeros) ;
+  for (int s = 0; s < T; s++) {
+    for (int t = s; t < T && t - s <= cov_ar; t++) {
+      double sum = 0 ;
+      int count = 0 ;
+      for (int i = 0; i < n; i++) {
+        double a = R(i, s) ;
+        double c = R(i, t) ;
+        if (std::isfinite(a) && std::isfinite(c)) {
+          sum += a * c ;
+          count++ ;
+        }
+      }
+      V(s, t) = sum / std::max(count, 1) ;
+      V(t, s) = V(s, t) ;
+    }
+  }
+  return(V) ;
+}
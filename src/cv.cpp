@@ -0,0 +1,207 @@
+# include "gsynth_types.h"
+# include <RcppArmadillo.h>
+# include <random>
+# ifdef _OPENMP
+# include <omp.h>
+# endif
+# include "interFE.h"
+// [[Rcpp::depends(RcppArmadillo)]]
+// [[Rcpp::plugins(cpp11)]]
+// [[Rcpp::plugins(openmp)]]
+
+using namespace Rcpp ;
+
+/* ******************* Cross-validation  *********************** */
+
+/* Folds are drawn serially up front, each from its own generator seeded
+   by (seed, fold), so they do not depend on the number of threads.
+   The k fold paths and the full-data path are then independent tasks
+   on an OpenMP team; inside a task the lambdas run in order, each
+   warm-started from the previous one, and the task owns its copies of
+   the panel. */
+
+/* held-out cells of one fold: n of the observed cells, redrawn until
+   every row and column keeps an observation */
+arma::uvec cv_fold (const arma::mat& I, const arma::uvec& obs, int n,
+                    int fold, int seed) {
+  std::seed_seq seq{(unsigned int) seed, (unsigned int) fold} ;
+  std::mt19937_64 gen(seq) ;
+  arma::uvec pool = obs ;
+  for (int tries = 0; tries < 1000; tries++) {
+    // partial fisher-yates: the first n of pool are a random subset
+    for (int i = 0; i < n; i++) {
+      std::uniform_int_distribution<int> pick(i, (int) pool.n_elem - 1) ;
+      std::swap(pool(i), pool(pick(gen))) ;
+    }
+    arma::uvec hold = pool.head(n) ;
+    arma::mat I_cv = I ;
+    I_cv.elem(hold).zeros() ;
+    if (arma::all(arma::sum(I_cv, 1) > 0) && arma::all(arma::sum(I_cv, 0) > 0)) {
+      return(hold) ;
+    }
+  }
+  Rcpp::stop("cannot draw a cross-validation fold that leaves every unit and period observed.") ;
+  return(arma::uvec()) ;
+}
+
+/* k-fold cross-validation of inter_fe_mc over lambda: MSPE on the
+   held-out cells and sigma2 of the full-data fit, for each lambda */
+// [[Rcpp::export]]
+List cv_mc (const arma::mat& Y,
+            const arma::cube& X,
+            const arma::mat& I,
+            const arma::vec& lambda,
+            int force,
+            double tol = 1e-5,
+            int k = 5,
+            int seed = 0,
+            int cores = 1
+            ) {
+  int nlambda = lambda.n_elem ;
+  arma::uvec obs = arma::find(I == 1) ; // observed cells
+  int n_obs = obs.n_elem ;
+  int n_cv = std::ceil(double(n_obs) * n_obs / I.n_elem) ; // cells kept
+  int n_hold = n_obs - n_cv ;
+  IterControl ctl = iter_control(tol) ;
+
+  std::vector<arma::uvec> folds(k) ;
+  for (int f = 0; f < k; f++) {
+    folds[f] = cv_fold(I, obs, n_hold, f, seed) ;
+  }
+
+  arma::mat SSE(nlambda, k, arma::fill::zeros) ;
+  arma::vec sigma2(nlambda) ;
+  sigma2.fill(arma::datum::nan) ;
+  SSE.fill(arma::datum::nan) ;
+
+  // tasks 0, ..., k-1: folds; task k: full data
+  int nthreads = thread_count(cores) ;
+  #pragma omp parallel for num_threads(nthreads) schedule(dynamic) if(nthreads > 1)
+  for (int f = 0; f <= k; f++) {
+    try {
+      arma::mat Y_cv = Y ;
+      arma::mat I_cv = I ;
+      if (f < k) {
+        Y_cv.elem(folds[f]).zeros() ;
+        I_cv.elem(folds[f]).zeros() ;
+      }
+      IterFit warm ;
+      for (int l = 0; l < nlambda; l++) {
+        InterFit est = inter_fe_mc_core(Y_cv, X, I_cv, 1, lambda(l), force,
+                                        ctl, &warm) ;
+        if (f < k) {
+          SSE(l, f) = accu(arma::square(Y.elem(folds[f]) - est.fit.elem(folds[f]))) ;
+        }
+        else {
+          sigma2(l) = est.sigma2 ;
+        }
+      }
+    } catch (...) {
+      // leave the task's entries as NaN
+    }
+  }
+
+  arma::vec MSPE = sum(SSE, 1) / (double(k) * n_hold) ;
+
+  List output ;
+  output["lambda"] = lambda ;
+  output["sigma2"] = sigma2 ;
+  output["MSPE"] = MSPE ;
+  return(output) ;
+}
+
+/* MSPE of leave-one-period-out prediction of the treated residuals U
+   (T * Ntr) from the factors F (T * k, with a column of ones for the
+   unit fe; k = 0 for none), over the pre-treatment cells of pre.
+   For a unit with pre-treatment periods S, dropping period t from the
+   least squares fit of U(S, i) on F(S, ) is a rank-one downdate of
+   F(S)'F(S) (Sherman-Morrison), so the prediction error is the
+   full-sample residual scaled by the leverage,
+   e_t = (u_t - f_t' lambda_i) / (1 - h_t), h_t = f_t' (F(S)'F(S))^{-1} f_t:
+   one cholesky per distinct S instead of a solve per unit and period. */
+// [[Rcpp::export]]
+double loo_mspe (const arma::mat& U,
+                 const arma::mat& F,
+                 const arma::mat& pre
+                 ) {
+  int T = U.n_rows ;
+  int N = U.n_cols ;
+  int k = F.n_cols ;
+  arma::mat E(T, N, arma::fill::zeros) ;     // prediction errors
+  arma::umat sing(T, N, arma::fill::zeros) ; // = 1 if the downdated fit is singular
+
+  arma::uvec S_prev ;
+  arma::mat R ; // upper cholesky factor of F(S)'F(S)
+  arma::mat H ; // k * |S|, R^{-T} F(S)': H'H is the hat matrix of S
+  bool ok = true ;
+  for (int i = 0; i < N; i++) {
+    arma::uvec S = arma::find(pre.col(i) != 0) ;
+    int nS = S.n_elem ;
+    if (nS == 0) {
+      continue ;
+    }
+    arma::vec u = U.col(i) ;
+    arma::vec uS = u.elem(S) ;
+    if (k == 0) {
+      for (int j = 0; j < nS; j++) {
+        E(S(j), i) = uS(j) ;
+      }
+      continue ;
+    }
+    // balanced panels with a common T0 share one factorization
+    if (S_prev.n_elem != S.n_elem || arma::any(S_prev != S)) {
+      arma::mat FS = F.rows(S) ;
+      ok = arma::chol(R, FS.t() * FS) ;
+      if (ok) {
+        H = arma::solve(arma::trimatl(R.t()), FS.t()) ;
+      }
+      S_prev = S ;
+    }
+    if (!ok) {
+      for (int j = 0; j < nS; j++) {
+        sing(S(j), i) = 1 ;
+      }
+      continue ;
+    }
+    arma::vec fit = H.t() * (H * uS) ;
+    arma::rowvec h = sum(arma::square(H), 0) ; // leverages
+    for (int j = 0; j < nS; j++) {
+      double d = 1 - h(j) ;
+      if (d < 1e-10) {
+        sing(S(j), i) = 1 ;
+      } else {
+        E(S(j), i) = (uS(j) - fit(j)) / d ;
+      }
+    }
+  }
+
+  /* sum up period by period, in the order the periods first appear
+     among the pre-treatment cells; as before, cross-validation stops
+     at the first period that cannot be left out */
+  arma::uvec seen(T, arma::fill::zeros) ;
+  double sum_e2 = 0 ;
+  double num_y = 0 ;
+  for (int i = 0; i < N; i++) {
+    for (int t = 0; t < T; t++) {
+      if (pre(t, i) == 0 || seen(t) == 1) {
+        continue ;
+      }
+      seen(t) = 1 ;
+      arma::uvec units = arma::find(pre.row(t) != 0) ;
+      bool stop = false ;
+      for (int j = 0; j < (int) units.n_elem; j++) {
+        if (sing(t, units(j)) == 1) {
+          stop = true ;
+        }
+      }
+      if (stop) {
+        return(num_y == 0 ? arma::datum::inf : sum_e2 / num_y) ;
+      }
+      for (int j = 0; j < (int) units.n_elem; j++) {
+        sum_e2 += E(t, units(j)) * E(t, units(j)) ;
+        num_y += 1 ;
+      }
+    }
+  }
+  return(num_y == 0 ? arma::datum::inf : sum_e2 / num_y) ;
+}
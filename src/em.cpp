@@ -0,0 +1,115 @@
+# include "gsynth_types.h"
+# include <RcppArmadillo.h>
+# include "interFE.h"
+// [[Rcpp::depends(RcppArmadillo)]]
+// [[Rcpp::plugins(cpp11)]]
+
+using namespace Rcpp ;
+
+/* ******************* EM  *********************** */
+
+/* The covariates do not change between em steps: they are demeaned,
+   screened and factored once, in the prepared panel. Each E step
+   writes the counterfactuals of the treated post-treatment cells over
+   the outcome in place; the M step then only has to demean the outcome
+   again (balanced panels) before the fit, which starts from the
+   factors of the previous step. */
+
+/* em of synth.em, from the counterfactual Y_ct and effects eff0 of the
+   initial fit: the last fit (as inter_fe / inter_fe_ub), the
+   counterfactual, the number of steps and the change of the effects
+   at each step */
+// [[Rcpp::export]]
+List synth_em (const arma::mat& Y,
+               const arma::cube& X,
+               const arma::mat& I,
+               const arma::uvec& id_tr, // treated columns, 1-based
+               const arma::mat& post,   // T * Ntr, = 1 for the imputed cells
+               arma::mat Y_ct,          // T * Ntr
+               arma::mat eff0,          // T * Ntr
+               int r,
+               int force,
+               const arma::mat& beta0,
+               double tol = 1e-5,
+               int svd_method = 0, // factor engine, see panel_factor
+               int precision = 0, // 1: factor extraction in single precision
+               Rcpp::Nullable<Rcpp::NumericMatrix> factor0 = R_NilValue // warm start
+               ) {
+  int T = Y.n_rows ;
+  int Ntr = id_tr.n_elem ;
+  int p = X.n_slices ;
+  int ub = arma::any(arma::vectorise(I) == 0) ; // unbalanced panel
+  FactorEngine engine = {svd_method, 10, 2, precision} ;
+  arma::mat F0 ;
+  if (factor0.isNotNull()) {
+    F0 = as<arma::mat>(factor0.get()) ;
+  }
+
+  arma::uvec tr = id_tr - 1 ;
+  arma::mat Y_tr = Y.cols(tr) ;
+
+  /* imputed cells, in the T * Ntr block and in the panel */
+  arma::uvec cell_tr = arma::find(post == 1) ;
+  arma::uvec cell(cell_tr.n_elem) ;
+  for (arma::uword k = 0; k < cell_tr.n_elem; k++) {
+    cell(k) = tr(cell_tr(k) / T) * T + cell_tr(k) % T ;
+  }
+
+  /* the outcome with imputed cells: prep.y.YY itself for inter_fe_ub,
+     which does not demean it; a raw copy for inter_fe */
+  PanelPrep prep ;
+  arma::mat Y_e ;
+  if (ub == 0) {
+    inter_fe_prep(prep, Y, X, force, arma::uvec()) ;
+    Y_e = Y ;
+  } else {
+    inter_fe_ub_prep(prep, Y, X, I, force, arma::uvec()) ;
+  }
+  arma::mat& Y_imp = (ub == 0) ? Y_e : prep.y.YY ;
+
+  IterControl ctl = iter_control(tol) ;
+  InterFit est ;
+  arma::mat eff(T, Ntr) ;
+  std::vector<double> trace ;
+  double diff = 100 ;
+  int niter = 0 ;
+  while (niter <= 500 && diff > tol) {
+    /* E step */
+    for (arma::uword k = 0; k < cell.n_elem; k++) {
+      Y_imp(cell(k)) = Y_ct(cell_tr(k)) ;
+    }
+
+    /* M step */
+    if (ub == 0) {
+      prep.y.YY = Y_e ;
+      inter_fe_prep_y(prep.y, force) ;
+      est = inter_fe_solve(prep.x, prep.y, r, force, beta0, ctl, engine, F0) ;
+    } else {
+      est = inter_fe_ub_solve(prep.x, prep.y, r, force, ctl, engine, F0) ;
+    }
+    for (int j = 0; j < Ntr; j++) {
+      Y_ct.col(j) = Y_imp.col(tr(j)) - est.residuals.col(tr(j)) ;
+    }
+    if (r > 0) {
+      F0 = est.factor ;
+    }
+
+    eff = Y_tr - Y_ct ;
+    diff = arma::norm(eff0 - eff, "fro") ;
+    eff0 = eff ;
+
+    trace.push_back(diff) ;
+    niter++ ;
+  }
+
+  List output ;
+  if (ub == 0) {
+    output["est"] = inter_fe_output(est, p, r, force) ;
+  } else {
+    output["est"] = inter_fe_ub_output(est, p, r, force) ;
+  }
+  output["Y.ct"] = Y_ct ;
+  output["niter"] = niter ;
+  output["trace.diff"] = trace ;
+  return(output) ;
+}
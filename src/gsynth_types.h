@@ -0,0 +1,17 @@
+# ifndef GSYNTH_TYPES_H
+# define GSYNTH_TYPES_H
+
+# include <cstddef>
+
+/* Armadillo takes its heap memory from these two functions, which
+   count the allocations (see arma_alloc_count): the tests use the
+   count to check that the iterative kernels allocate nothing per
+   iteration. This header comes ahead of RcppArmadillo.h in every
+   file, RcppExports.cpp included, so the whole package uses them. */
+void* gsynth_alloc (std::size_t n_bytes) ;
+void gsynth_free (void* ptr) ;
+
+# define ARMA_ALIEN_MEM_ALLOC_FUNCTION gsynth_alloc
+# define ARMA_ALIEN_MEM_FREE_FUNCTION gsynth_free
+
+# endif
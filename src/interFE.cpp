@@ -1,19 +1,425 @@
+# include "gsynth_types.h"
 # include <RcppArmadillo.h>
+# include <random>
+# include <chrono>
+# include <algorithm>
+# include <atomic>
+# include <cstdlib>
+# ifdef _OPENMP
+# include <omp.h>
+# endif
+# include "interFE.h"
 // [[Rcpp::depends(RcppArmadillo)]]
 // [[Rcpp::plugins(cpp11)]]
+// [[Rcpp::plugins(openmp)]]
 
 using namespace Rcpp ;
 
+/* ******************* Internal Kernels  *********************** */
+
+IterControl iter_control (double tol, Rcpp::Nullable<Rcpp::List> control) {
+  IterControl ctl = {0, tol, 0, 0, 0} ; // budget: see iter_budget
+  if (control.isNull()) {
+    return(ctl) ;
+  }
+  List cl(control.get()) ;
+  if (cl.containsElementNamed("max.iter")) {
+    ctl.max_iter = as<int>(cl["max.iter"]) ;
+  }
+  if (cl.containsElementNamed("tol")) {
+    ctl.tol = as<double>(cl["tol"]) ;
+  }
+  if (cl.containsElementNamed("criterion")) {
+    std::string criterion = as<std::string>(cl["criterion"]) ;
+    if (criterion == "legacy") {
+      ctl.criterion = 0 ;
+    } else if (criterion == "absolute") {
+      ctl.criterion = 1 ;
+    } else if (criterion == "relative") {
+      ctl.criterion = 2 ;
+    } else {
+      Rcpp::stop("criterion should be \"legacy\", \"absolute\" or \"relative\".") ;
+    }
+  }
+  if (cl.containsElementNamed("accel")) {
+    ctl.accel = as<int>(cl["accel"]) ;
+  }
+  if (cl.containsElementNamed("trace")) {
+    ctl.trace = as<int>(cl["trace"]) ;
+  }
+  return(ctl) ;
+}
+
+DataFrame trace_output (const IterTrace& trace) {
+  return(DataFrame::create(Named("objective") = trace.objective,
+                           Named("step") = trace.step,
+                           Named("time") = trace.time)) ;
+}
+
+/* cap on the OpenMP team of the parallel drivers, 0 for none; forked
+   pool workers set it to 1, as libgomp's threads do not survive a fork
+   of a process that has already used them */
+static int thread_cap = 0 ;
+
+// [[Rcpp::export]]
+void set_thread_cap (int cap) {
+  thread_cap = cap ;
+}
+
+int thread_count (int cores) {
+  if (thread_cap > 0 && cores > thread_cap) {
+    return(thread_cap) ;
+  }
+  return(std::max(cores, 1)) ;
+}
+
+/* Armadillo's allocator, see gsynth_types.h */
+static std::atomic<long> alloc_calls(0) ;
+
+void* gsynth_alloc (std::size_t n_bytes) {
+  alloc_calls.fetch_add(1, std::memory_order_relaxed) ;
+  return(std::malloc(n_bytes)) ;
+}
+
+void gsynth_free (void* ptr) {
+  std::free(ptr) ;
+}
+
+/* number of heap allocations made by Armadillo so far */
+// [[Rcpp::export]]
+double arma_alloc_count () {
+  return(double(alloc_calls.load())) ;
+}
+
+/* E(cells) = FE(cells) */
+void fill_cells (arma::mat& E, const arma::mat& FE, const CellIndex& cells) {
+  for (arma::uword k = 0; k < cells.loc.n_cols; k++) {
+    E(cells.loc(0, k), cells.loc(1, k)) = FE(cells.loc(0, k), cells.loc(1, k)) ;
+  }
+}
+
+/* E(cells), in the order of the index */
+arma::vec cells_of (const arma::mat& E, const CellIndex& cells) {
+  arma::vec v(cells.loc.n_cols) ;
+  for (arma::uword k = 0; k < cells.loc.n_cols; k++) {
+    v(k) = E(cells.loc(0, k), cells.loc(1, k)) ;
+  }
+  return(v) ;
+}
+
+/* E(cells) = v */
+void set_cells (arma::mat& E, const arma::vec& v, const CellIndex& cells) {
+  for (arma::uword k = 0; k < cells.loc.n_cols; k++) {
+    E(cells.loc(0, k), cells.loc(1, k)) = v(k) ;
+  }
+}
+
+/* E(cells) = 0 */
+void zero_cells (arma::mat& E, const CellIndex& cells) {
+  for (arma::uword k = 0; k < cells.loc.n_cols; k++) {
+    E(cells.loc(0, k), cells.loc(1, k)) = 0 ;
+  }
+}
+
+/* The two-way transforms touch every cell twice: one read sweep down
+   the columns accumulates the column sums and, in xi, which stays in
+   cache, the row sums (the grand sum is the sum of the column sums);
+   one write sweep then subtracts alpha_i + xi_t + c. Both inner loops
+   run over contiguous memory and vectorize, and nothing is allocated. */
+void twoway_demean (double* y, int T, int N, int force, int centred,
+                    double& mu, double* alpha, double* xi) {
+  int unit = (force == 1 || force == 3) ;
+  int time = (force == 2 || force == 3) ;
+  std::fill(xi, xi + T, 0.0) ;
+  double total = 0 ;
+  for (int i = 0; i < N; i++) {
+    const double* c = y + (size_t) i * T ;
+    double s = 0 ;
+    for (int t = 0; t < T; t++) {
+      s += c[t] ;
+      xi[t] += c[t] ;
+    }
+    alpha[i] = s / T ;
+    total += s ;
+  }
+  mu = total / (double(T) * N) ;
+  for (int t = 0; t < T; t++) {
+    xi[t] = time ? xi[t] / N : 0 ;
+  }
+  if (!unit) {
+    std::fill(alpha, alpha + N, 0.0) ;
+  }
+
+  // Y - mu; Y - alpha_i; Y - xi_t; Y - alpha_i - xi_t + mu
+  double shift = (force == 0) ? mu : ((force == 3) ? -mu : 0) ;
+  for (int i = 0; i < N; i++) {
+    double* c = y + (size_t) i * T ;
+    double a = alpha[i] + shift ;
+    for (int t = 0; t < T; t++) {
+      c[t] -= a + xi[t] ;
+    }
+  }
+
+  if (centred == 1) {
+    for (int i = 0; unit && i < N; i++) {
+      alpha[i] -= mu ;
+    }
+    for (int t = 0; time && t < T; t++) {
+      xi[t] -= mu ;
+    }
+  }
+}
+
+void twoway_demean_cube (arma::cube& X, int force, int centred,
+                         arma::mat& mu_X, arma::mat& alpha_X,
+                         arma::mat& xi_X) {
+  int T = X.n_rows ;
+  int N = X.n_cols ;
+  int p = X.n_slices ;
+  mu_X.set_size(p, 1) ;
+  alpha_X.set_size(N, p) ;
+  xi_X.set_size(T, p) ;
+  for (int k = 0; k < p; k++) {
+    twoway_demean(X.slice(k).memptr(), T, N, force, centred, mu_X(k, 0),
+                  alpha_X.colptr(k), xi_X.colptr(k)) ;
+  }
+}
+
+/* remove grand mean / unit / time means from Y in place, as Y_demean */
+void demean_into (arma::mat& Y, double& mu_Y, arma::mat& alpha_Y,
+                  arma::mat& xi_Y, int force) {
+  alpha_Y.set_size(Y.n_cols, 1) ;
+  xi_Y.set_size(Y.n_rows, 1) ;
+  twoway_demean(Y.memptr(), Y.n_rows, Y.n_cols, force, 0, mu_Y,
+                alpha_Y.memptr(), xi_Y.memptr()) ;
+}
+
+/* add back what demean_into removed; one sweep, in the order of the
+   terms: + mu (force 0), + alpha_i (1, 3), + xi_t (2, 3), - mu (3) */
+void remean_into (arma::mat& Y, double mu_Y, const arma::mat& alpha_Y,
+                  const arma::mat& xi_Y, int force) {
+  int T = Y.n_rows ;
+  int N = Y.n_cols ;
+  int unit = (force == 1 || force == 3) ;
+  int time = (force == 2 || force == 3) ;
+  const double* xi = xi_Y.memptr() ;
+  for (int i = 0; i < N; i++) {
+    double* c = Y.colptr(i) ;
+    double a = unit ? alpha_Y(i) : 0 ;
+    for (int t = 0; t < T; t++) {
+      double v = c[t] ;
+      if (force == 0) {
+        v += mu_Y ;
+      }
+      if (unit) {
+        v += a ;
+      }
+      if (time) {
+        v += xi[t] ;
+      }
+      if (force == 3) {
+        v -= mu_Y ;
+      }
+      c[t] = v ;
+    }
+  }
+}
+
+/* The slices of a cube are stored one after another, so a T * N * p
+   cube is, without copying, the NT * p design matrix whose k-th column
+   is vec(X_k). Below Xd is such a view (no copy, strict aux memory),
+   so products with the design are single BLAS calls. */
+
+/* fit = sum_k X_k * beta_k */
+void covar_fit_into (arma::mat& fit, const arma::cube& X,
+                     const arma::mat& beta) {
+  const arma::mat Xd(const_cast<double*>(X.memptr()), X.n_rows * X.n_cols,
+                     X.n_slices, false, true) ;
+  fit.set_size(X.n_rows, X.n_cols) ;
+  arma::vec f(fit.memptr(), fit.n_elem, false, true) ;
+  f = Xd * beta ; // gemv
+}
+
+/* U = Y - sum_k X_k * beta_k */
+void covar_resid_into (arma::mat& U, const arma::mat& Y,
+                       const arma::cube& X, const arma::mat& beta) {
+  const arma::mat Xd(const_cast<double*>(X.memptr()), X.n_rows * X.n_cols,
+                     X.n_slices, false, true) ;
+  U = Y ;
+  arma::vec u(U.memptr(), U.n_elem, false, true) ;
+  u -= Xd * beta ; // gemv
+}
+
+/* beta = (X'X)^{-1} X' vec(R), X the NT * p design */
+void panel_beta_into (arma::mat& beta, const arma::cube& X,
+                      const GramSolver& gram, const arma::mat& R) {
+  const arma::mat Xd(const_cast<double*>(X.memptr()), X.n_rows * X.n_cols,
+                     X.n_slices, false, true) ;
+  const arma::vec r(const_cast<double*>(R.memptr()), R.n_elem, false, true) ;
+  arma::mat xy = Xd.t() * r ; // gemv
+  gram_solve(beta, gram, xy) ;
+}
+
+/* working copies of the panel, restricted to (possibly repeated)
+   units; the copy the estimators make anyway, so a bootstrap
+   replicate needs no resampled panel of its own */
+void panel_gather (arma::mat& YY, arma::cube& XX, const arma::mat& Y,
+                   const arma::cube& X, const arma::uvec& units) {
+  if (units.n_elem == 0) {
+    YY = Y ;
+    XX = X ;
+    return ;
+  }
+  YY = Y.cols(units) ;
+  XX.set_size(X.n_rows, units.n_elem, X.n_slices) ;
+  for (arma::uword k = 0; k < X.n_slices; k++) {
+    for (arma::uword i = 0; i < units.n_elem; i++) {
+      XX.slice(k).col(i) = X.slice(k).col(units(i)) ;
+    }
+  }
+}
+
+/* xx = X'X, the p * p gram matrix of the covariates */
+void gram_into (arma::mat& xx, const arma::cube& X) {
+  const arma::mat Xd(const_cast<double*>(X.memptr()), X.n_rows * X.n_cols,
+                     X.n_slices, false, true) ;
+  xx = Xd.t() * Xd ; // tr(X_k' X_m); syrk
+}
+
+/* Cholesky factor of D xx D, D = diag(xx)^{-1/2}, or a column-pivoted
+   qr if it is (nearly) singular. Scaling first keeps the rank test
+   invariant to the units of the covariates; the relative tolerance
+   applies to their correlation matrix. */
+GramSolver gram_factor (const arma::mat& xx) {
+  int p = xx.n_rows ;
+  double tol = 1e-10 ;
+  GramSolver gram ;
+  gram.method = 0 ;
+  gram.rank = p ;
+  if (p == 0) {
+    return(gram) ;
+  }
+  gram.s.set_size(p) ;
+  for (int k = 0; k < p; k++) {
+    // a zero column stays zero and is pivoted out below
+    gram.s(k) = xx(k, k) > 0 ? 1 / sqrt(xx(k, k)) : 0 ;
+  }
+  arma::mat xs = xx % (gram.s * gram.s.t()) ;
+  if (arma::chol(gram.R, xs)) {
+    arma::vec d = arma::square(gram.R.diag()) ;
+    if (d.min() > tol * d.max()) {
+      return(gram) ;
+    }
+  }
+  gram.method = 1 ;
+  arma::qr(gram.Q, gram.R, gram.piv, xs, "vector") ;
+  double r0 = std::abs(gram.R(0, 0)) ;
+  gram.rank = 0 ;
+  while (gram.rank < p && std::abs(gram.R(gram.rank, gram.rank)) > tol * r0) {
+    gram.rank++ ;
+  }
+  return(gram) ;
+}
+
+/* a given (X'X)^{-1}, as passed in from R */
+GramSolver gram_inverse (const arma::mat& xxinv) {
+  GramSolver gram ;
+  gram.method = 2 ;
+  gram.rank = xxinv.n_rows ;
+  gram.R = xxinv ;
+  return(gram) ;
+}
+
+/* beta = (X'X)^{-1} xy; if X'X is rank deficient, the basic solution
+   with zero coefficients on the pivoted-out columns */
+void gram_solve (arma::mat& beta, const GramSolver& gram,
+                 const arma::mat& xy) {
+  if (gram.method == 0) {
+    // beta = D R^{-1} R'^{-1} D xy by substitution, which needs no
+    // scratch (and works in place, if beta is xy)
+    int p = xy.n_rows ;
+    beta.set_size(p, xy.n_cols) ;
+    for (arma::uword c = 0; c < xy.n_cols; c++) {
+      double* b = beta.colptr(c) ;
+      for (int k = 0; k < p; k++) {
+        double v = xy(k, c) * gram.s(k) ;
+        for (int m = 0; m < k; m++) {
+          v -= gram.R(m, k) * b[m] ;
+        }
+        b[k] = v / gram.R(k, k) ;
+      }
+      for (int k = p - 1; k >= 0; k--) {
+        double v = b[k] ;
+        for (int m = k + 1; m < p; m++) {
+          v -= gram.R(k, m) * b[m] ;
+        }
+        b[k] = v / gram.R(k, k) ;
+      }
+      for (int k = 0; k < p; k++) {
+        b[k] *= gram.s(k) ;
+      }
+    }
+  }
+  else if (gram.method == 1) {
+    beta.zeros(xy.n_rows, xy.n_cols) ;
+    if (gram.rank > 0) {
+      int q = gram.rank ;
+      arma::mat z = gram.Q.head_cols(q).t() * (xy.each_col() % gram.s) ;
+      arma::mat b = arma::solve(arma::trimatu(gram.R.submat(0, 0, q - 1, q - 1)), z) ;
+      for (int k = 0; k < q; k++) {
+        beta.row(gram.piv(k)) = b.row(k) * gram.s(gram.piv(k)) ;
+      }
+    }
+  }
+  else {
+    beta = gram.R * xy ;
+  }
+}
+
+/* drop covariates that are linear combinations of the others (after
+   demeaning) and mark them in X_invar, as for time-invariant ones;
+   on return gram holds the factorization of the remaining X'X */
+int shed_collinear (arma::cube& XX, arma::mat& mu_X, arma::mat& alpha_X,
+                    arma::mat& xi_X, arma::mat& X_invar, GramSolver& gram) {
+  int p1 = XX.n_slices ;
+  if (p1 == 0) {
+    return(p1) ;
+  }
+  arma::mat xx ;
+  gram_into(xx, XX) ;
+  gram = gram_factor(xx) ;
+  if (gram.rank == p1) {
+    return(p1) ;
+  }
+  arma::uvec orig = arma::find(X_invar == 0) ; // covariate of each slice
+  arma::uvec drop = arma::sort(gram.piv.tail(p1 - gram.rank), "descend") ;
+  for (arma::uword k = 0; k < drop.n_elem; k++) {
+    arma::uword i = drop(k) ;
+    XX.shed_slice(i) ;
+    mu_X.shed_row(i) ;
+    alpha_X.shed_col(i) ;
+    xi_X.shed_col(i) ;
+    X_invar(orig(i), 0) = 1 ;
+  }
+  p1 = XX.n_slices ;
+  if (p1 > 0) {
+    gram_into(xx, XX) ;
+    gram = gram_factor(xx) ;
+  }
+  return(p1) ;
+}
+
+
 /* ******************* Useful Functions  *********************** */
 
 /* cross product */
-arma::mat crossprod (arma::mat x, arma::mat y) {
+arma::mat crossprod (const arma::mat& x, const arma::mat& y) {
   return(x.t() * y);
 }
 
 /* Expectation :E if Iij==0, Eij=FEij */
-arma::mat E_adj (arma::mat E, arma::mat FE,
-                 arma::mat I) {
+arma::mat E_adj (const arma::mat& E, const arma::mat& FE,
+                 const arma::mat& I) {
   int T = E.n_rows ;
   int N = E.n_cols ;
   arma::mat EE = E ;
@@ -28,7 +434,7 @@ arma::mat E_adj (arma::mat E, arma::mat FE,
 }
 
 /* reset FEij=0 if Iij==0 , for residuals or IC*/
-arma::mat FE_adj (arma::mat FE, arma::mat I) {
+arma::mat FE_adj (const arma::mat& FE, const arma::mat& I) {
   int T = FE.n_rows ;
   int N = FE.n_cols ;
   arma::mat FEE = FE ;
@@ -42,8 +448,31 @@ arma::mat FE_adj (arma::mat FE, arma::mat I) {
   return(FEE) ;
 }
 
+/* cell index of the observed (Iij != 0) or missing (Iij == 0) cells */
+CellIndex cell_index (const arma::mat& I, bool observed) {
+  int T = I.n_rows ;
+  int N = I.n_cols ;
+  arma::uword n = 0 ;
+  CellIndex idx ;
+  idx.loc.set_size(2, T * N) ;
+  idx.colptr.set_size(N + 1) ;
+  for (int j = 0; j < N; j++) {
+    idx.colptr(j) = n ;
+    for (int i = 0; i < T; i++) {
+      if ((I(i, j) != 0) == observed) {
+        idx.loc(0, n) = i ;
+        idx.loc(1, n) = j ;
+        n++ ;
+      }
+    }
+  }
+  idx.colptr(N) = n ;
+  idx.loc.resize(2, n) ;
+  return(idx) ;
+}
+
 /* drop values if Iij == 1 */
-arma::mat FE_missing (arma::mat FE, arma::mat I) {
+arma::mat FE_missing (const arma::mat& FE, const arma::mat& I) {
   int T = FE.n_rows ;
   int N = FE.n_cols ;
   arma::mat FEE = FE ;
@@ -59,7 +488,7 @@ arma::mat FE_missing (arma::mat FE, arma::mat I) {
 
 /* adjust unbalanced data */
 // [[Rcpp::export]]
-arma::mat data_ub_adj (arma::mat I_data, arma::mat data) {
+arma::mat data_ub_adj (const arma::mat& I_data, const arma::mat& data) {
   int count = I_data.n_rows ;
   //int total = data.n_rows ;
   int nov = data.n_cols ;
@@ -77,54 +506,25 @@ arma::mat data_ub_adj (arma::mat I_data, arma::mat data) {
 
 /* Three dimensional matrix inverse */
 // [[Rcpp::export]]
-arma::mat XXinv (arma::cube X) { 
-  int p = X.n_slices ;
-  arma::mat xx(p, p, arma::fill::zeros) ;
-  for (int k = 0; k < p; k++) {
-    for (int m = 0; m < p; m++) {
-      if (k > m) {
-        xx(k, m) = xx(m, k);
-      }
-      else {
-        xx(k, m) = trace(crossprod(X.slice(k), X.slice(m))) ;
-      }
-    }
-  } 
-  return(inv(xx)) ;
+arma::mat XXinv (const arma::cube& X) { 
+  arma::mat xx ;
+  gram_into(xx, X) ;
+  arma::mat xxinv ;
+  gram_solve(xxinv, gram_factor(xx),
+             arma::eye<arma::mat>(xx.n_rows, xx.n_rows)) ;
+  return(xxinv) ;
 }
 
 /* unbalanced panel: response demean function */
 // [[Rcpp::export]]
-List Y_demean (arma::mat Y, int force) {
+List Y_demean (const arma::mat& Y, int force) {
   int T = Y.n_rows ;
   int N = Y.n_cols ;
   double mu_Y = 0 ;
   arma::mat alpha_Y(N, 1, arma::fill::zeros) ; 
   arma::mat xi_Y(T, 1, arma::fill::zeros) ;
   arma::mat YY = Y ;
-
-  mu_Y  =  accu(YY)/(N*T) ;
-  if (force == 0) {
-    YY = YY - mu_Y ;
-  } 
-  
-  /* unit fixed effects */
-  if (force == 1) {
-    alpha_Y  =  mean(YY, 0).t() ; // colMeans, (N * 1) matrix
-    YY  =  YY - repmat(alpha_Y.t(), T, 1) ; // (T * N) matrix  
-  }
-  
-  /* time fixed effects  */
-  if ( force == 2) {
-    xi_Y  =  mean(YY, 1) ; //rowMeans, (N * 1) matrix
-    YY  =  YY - repmat(xi_Y, 1, N);  
-  }
-
-  if (force == 3) {
-    alpha_Y  =  mean(YY, 0).t() ;
-    xi_Y  =  mean(YY, 1) ;
-    YY  =  YY - repmat(alpha_Y.t(), T, 1) - repmat(xi_Y, 1, N) + mu_Y ;
-  }
+  demean_into(YY, mu_Y, alpha_Y, xi_Y, force) ;
 
   List result ;
   result["mu_Y"] = mu_Y ;
@@ -139,50 +539,64 @@ List Y_demean (arma::mat Y, int force) {
   return(result) ;
 }
 
+/* additive fe given the means of Y and X and beta */
+AddFE fe_add_core (const arma::mat& alpha_X,
+                   const arma::mat& xi_X,
+                   const arma::mat& mu_X,
+                   const arma::mat& alpha_Y,
+                   const arma::mat& xi_Y,
+                   double mu_Y,
+                   const arma::mat& beta,
+                   int T,
+                   int N,
+                   int force) {
+  AddFE fe ;
+  fe.alpha.zeros(N, 1) ;
+  fe.xi.zeros(T, 1) ;
+
+  fe.mu  =  mu_Y - crossprod(mu_X, beta)(0,0) ;
+  if (force ==1 || force == 3) {
+    fe.alpha  =  alpha_Y - alpha_X * beta - fe.mu ; 
+  }
+  if (force == 2 || force == 3) {
+    fe.xi  =  xi_Y - xi_X * beta - fe.mu ;
+  } 
+  return(fe) ;
+}
+
+/* T * N additive fe: mu + alpha_i + xi_t */
+arma::mat fe_add_dense (const AddFE& fe, int T, int N) {
+  arma::mat FE_ad(T, N) ;
+  FE_ad.fill(fe.mu) ;
+  FE_ad.each_row() += fe.alpha.t() ;
+  FE_ad.each_col() += fe.xi ;
+  return(FE_ad) ;
+}
+
 /* estimate additive fe for unbalanced panel */
 // [[Rcpp::export]]
-List fe_add (arma::mat alpha_X,
-             arma::mat xi_X,
-             arma::mat mu_X,
-             arma::mat alpha_Y,
-             arma::mat xi_Y,
+List fe_add (const arma::mat& alpha_X,
+             const arma::mat& xi_X,
+             const arma::mat& mu_X,
+             const arma::mat& alpha_Y,
+             const arma::mat& xi_Y,
              double mu_Y,
-             arma::mat beta,
+             const arma::mat& beta,
              int T,
              int N,
              int p,
              int force) {
-  
-  arma::mat FE_ad(T, N, arma::fill::zeros) ;
-  double mu = 0 ;
-  arma::mat alpha(N, 1, arma::fill::zeros) ;
-  arma::mat xi(T, 1, arma::fill::zeros) ;
-
-  mu  =  mu_Y - crossprod(mu_X, beta)(0,0) ;
-  if (force ==1 || force == 3) {
-    alpha  =  alpha_Y - alpha_X * beta - mu ; 
-  }
-  if (force == 2 || force == 3) {
-    xi  =  xi_Y - xi_X * beta - mu ;
-  } 
-
-  FE_ad = FE_ad + mu ;
-
-  if (force ==1 || force == 3) {
-    FE_ad = FE_ad + repmat(alpha.t(), T, 1) ;
-  }
-  if (force == 2 || force == 3) {
-    FE_ad = FE_ad + repmat(xi, 1, N) ;
-  }
+  AddFE fe = fe_add_core(alpha_X, xi_X, mu_X, alpha_Y, xi_Y, mu_Y,
+                         beta, T, N, force) ;
 
   List result ;
-  result["mu"] = mu ;
-  result["FE_ad"] = FE_ad ;
+  result["mu"] = fe.mu ;
+  result["FE_ad"] = fe_add_dense(fe, T, N) ;
   if (force ==1 || force == 3) {
-    result["alpha"] = alpha ;
+    result["alpha"] = fe.alpha ;
   }
   if (force == 2 || force == 3) {
-    result["xi"] = xi ;
+    result["xi"] = fe.xi ;
   }
 
   return(result) ;
@@ -190,8 +604,8 @@ List fe_add (arma::mat alpha_X,
 
 /* estimate additive fe for unbalanced panel, without covariates */
 // [[Rcpp::export]]
-List fe_add2 (arma::mat alpha_Y,
-              arma::mat xi_Y,
+List fe_add2 (const arma::mat& alpha_Y,
+              const arma::mat& xi_Y,
               double mu_Y,
               int T,
               int N,
@@ -231,74 +645,732 @@ List fe_add2 (arma::mat alpha_Y,
   return(result) ;
 }
 
+/* additive fe of a completed panel from its row and column sums;
+   same as Y_demean followed by fe_add2 without the T * N copies */
+void fe_add_sums (const arma::mat& rs, const arma::mat& cs, int force,
+                  double& mu, arma::mat& alpha, arma::mat& xi) {
+  int T = rs.n_rows ;
+  int N = cs.n_rows ;
+  mu = accu(cs)/(double(N) * T) ;
+  if (force == 1 || force == 3) {
+    alpha = cs/T - mu ;
+  }
+  if (force == 2 || force == 3) {
+    xi = rs/N - mu ;
+  }
+}
+
+
+/* ******************* Factor Extraction  *********************** */
+
+/* the engines below only touch E through products with thin
+   matrices, so E may be dense or sparse plus low-rank */
+inline int op_rows (const arma::mat& E) {
+  return(E.n_rows) ;
+}
+
+inline int op_cols (const arma::mat& E) {
+  return(E.n_cols) ;
+}
+
+inline arma::mat op_mul (const arma::mat& E, const arma::mat& X) {
+  return(E * X) ;
+}
+
+inline arma::mat op_tmul (const arma::mat& E, const arma::mat& X) {
+  return(E.t() * X) ;
+}
+
+inline const arma::mat& op_dense (const arma::mat& E) {
+  return(E) ;
+}
+
+inline int op_rows (const SpLowRank& E) {
+  return(E.S.n_rows) ;
+}
+
+inline int op_cols (const SpLowRank& E) {
+  return(E.S.n_cols) ;
+}
+
+/* O(nnz k + (T+N) q k) for X with k columns and q = rank of A*B' */
+inline arma::mat op_mul (const SpLowRank& E, const arma::mat& X) {
+  if (E.A.n_cols == 0) {
+    return(E.S * X) ;
+  }
+  return(E.S * X + E.A * (E.B.t() * X)) ;
+}
+
+inline arma::mat op_tmul (const SpLowRank& E, const arma::mat& X) {
+  if (E.A.n_cols == 0) {
+    return(E.S.t() * X) ;
+  }
+  return(E.S.t() * X + E.B * (E.A.t() * X)) ;
+}
+
+inline arma::mat op_dense (const SpLowRank& E) {
+  if (E.A.n_cols == 0) {
+    return(arma::mat(E.S)) ;
+  }
+  return(arma::mat(E.S) + E.A * E.B.t()) ;
+}
+
+/* gaussian test matrix; a fixed seed keeps R's RNG stream untouched
+   and the randomized factors reproducible */
+arma::mat sketch_matrix (int n, int k) {
+  std::mt19937 gen(20180117) ;
+  std::normal_distribution<double> gauss(0.0, 1.0) ;
+  arma::mat Omega(n, k) ;
+  for (arma::uword i = 0; i < Omega.n_elem; i++) {
+    Omega(i) = gauss(gen) ;
+  }
+  return(Omega) ;
+}
+
+/* top-r singular triplets of E by randomized range finder
+   (Halko, Martinsson and Tropp 2011); false if svd fails */
+template <typename Op>
+bool svd_rand (arma::mat& U, arma::vec& s, arma::mat& V,
+               const Op& E, int r, int oversample, int power) {
+  int T = op_rows(E) ;
+  int N = op_cols(E) ;
+  int k = std::min(r + oversample, std::min(T, N)) ;
+  arma::mat Q ;
+  arma::mat R ;
+  arma::mat Ub ;
+
+  arma::mat Y = op_mul(E, sketch_matrix(N, k)) ; // T * k sketch of the range
+  arma::qr_econ(Q, R, Y) ;
+  for (int i = 0; i < power; i++) { // power iterations sharpen the spectrum
+    Y = op_tmul(E, Q) ;
+    arma::qr_econ(Q, R, Y) ;
+    Y = op_mul(E, Q) ;
+    arma::qr_econ(Q, R, Y) ;
+  }
+  arma::mat B = op_tmul(E, Q).t() ; // k * N
+  if (!arma::svd_econ(Ub, s, V, B)) {
+    return(false) ;
+  }
+  U = Q * Ub.head_cols(r) ;
+  s = s.head(r) ;
+  V = V.head_cols(r) ;
+  return(true) ;
+}
+
+/* top-r singular triplets of E by block power steps started from
+   a previous factor estimate F0 (T * r); O(NTr) per step. At least
+   steps steps are taken, then more until the subspace is stable: the
+   sine of its largest angle to that of the previous step is below
+   WARM_TOL. False if it is not stable after WARM_MAX_STEPS, so the
+   exact engine is used and the fit stays within tolerance of it */
+const double WARM_TOL = 1e-10 ;
+const int WARM_MAX_STEPS = 200 ;
+
+template <typename Op>
+bool svd_warm (arma::mat& U, arma::vec& s, arma::mat& V,
+               const Op& E, const arma::mat& F0, int steps) {
+  arma::mat Q ;
+  arma::mat Q_old ;
+  arma::mat R ;
+  arma::mat Ub ;
+  arma::mat Y ;
+
+  arma::qr_econ(Q, R, F0) ;
+  bool stable = false ;
+  for (int i = 0; i < WARM_MAX_STEPS && !stable; i++) {
+    Q_old = Q ;
+    Y = op_tmul(E, Q) ;
+    arma::qr_econ(Q, R, Y) ;
+    Y = op_mul(E, Q) ;
+    arma::qr_econ(Q, R, Y) ;
+    if (i + 1 >= steps) {
+      // residual of the old basis projected on the new one
+      arma::mat D = Q_old - Q * (Q.t() * Q_old) ;
+      stable = arma::norm(D, 2) < WARM_TOL ;
+    }
+  }
+  if (!stable) {
+    return(false) ;
+  }
+  arma::mat B = op_tmul(E, Q).t() ; // r * N
+  if (!arma::svd_econ(Ub, s, V, B)) {
+    return(false) ;
+  }
+  U = Q * Ub ;
+  return(true) ;
+}
+
+/* factors, loadings and eigenvalues by the randomized or warm
+   engine; false when the exact path has to be taken instead:
+   the sketch would not be smaller than E, or factor0 is not a
+   T * r seed. factor0 is only read before factor is written,
+   so the previous factor can be passed as the seed */
+template <typename Op>
+bool factor_approx (const Op& E, int r, const FactorEngine& engine,
+                    arma::mat& factor, arma::mat& lambda, arma::mat& VNT,
+                    const arma::mat& factor0) {
+  int T = op_rows(E) ;
+  int N = op_cols(E) ;
+  arma::mat U ;
+  arma::vec s ;
+  arma::mat V ;
+  bool approx = false ;
+
+  if (r > 0 && r < std::min(T, N)) {
+    if (engine.method == 1 && r + engine.oversample < std::min(T, N)) {
+      approx = svd_rand(U, s, V, E, r, engine.oversample, engine.power) ;
+    }
+    else if (engine.method == 2 && factor0.n_rows == (arma::uword) T &&
+             factor0.n_cols == (arma::uword) r) {
+      approx = svd_warm(U, s, V, E, factor0, std::max(engine.power, 1)) ;
+    }
+  }
+  if (!approx) {
+    return(false) ;
+  }
+
+  // eigenvalues of the gram matrix are s^2/(N*T)
+  if (T < N) {
+    factor = U * sqrt(double(T)) ;
+    lambda = op_tmul(E, factor)/T ;
+  }
+  else {
+    lambda = V * sqrt(double(N)) ;
+    factor = op_mul(E, lambda)/N ;
+  }
+  VNT = diagmat(arma::square(s)/(double(N) * T)) ;
+  return(true) ;
+}
+
+/* exact factors, loadings and eigenvalues from the gram matrix of E,
+   computed in the element type of E; the results are double */
+template <typename eT>
+void factor_gram (const arma::Mat<eT>& E, int r, arma::mat& factor,
+                  arma::mat& lambda, arma::mat& VNT) {
+  int T = E.n_rows ;
+  int N = E.n_cols ;
+  arma::Mat<eT> U ;
+  arma::Col<eT> s ;
+  arma::Mat<eT> V ;
+  eT NT = eT(double(N) * T) ;
+
+  if (T < N) {
+    arma::Mat<eT> EE = E * E.t() / NT ;
+    arma::svd(U, s, V, EE) ;
+    arma::Mat<eT> F = U.head_cols(r) * eT(sqrt(double(T))) ;
+    factor = arma::conv_to<arma::mat>::from(F) ;
+    lambda = arma::conv_to<arma::mat>::from(arma::Mat<eT>(E.t() * F)) / T ;
+  }
+  else {
+    arma::Mat<eT> EE = E.t() * E / NT ;
+    arma::svd(U, s, V, EE) ;
+    arma::Mat<eT> L = U.head_cols(r) * eT(sqrt(double(N))) ;
+    lambda = arma::conv_to<arma::mat>::from(L) ;
+    factor = arma::conv_to<arma::mat>::from(arma::Mat<eT>(E * L)) / N ;
+  }
+  VNT = diagmat(arma::conv_to<arma::vec>::from(s.head_rows(r))) ;
+}
+
+/* svd of the square matrix work.EE, as arma::svd computes it (lapack
+   dgesdd, all singular vectors), but into the buffers of work, the
+   lapack workspace included; EE is overwritten. False if it fails */
+bool gram_svd (FactorWork& work) {
+  arma::blas_int n = work.EE.n_rows ;
+  arma::blas_int info = 0 ;
+  char jobz = 'A' ;
+  if (!work.EE.is_finite()) {
+    return(false) ;
+  }
+  work.U.set_size(n, n) ;
+  work.s.set_size(n) ;
+  work.Vt.set_size(n, n) ;
+  work.iwork.set_size(8 * n) ;
+  if (n == 0) {
+    return(true) ;
+  }
+  // the larger of the documented minimum and lapack's optimum
+  double query = 0 ;
+  arma::blas_int lwork = -1 ;
+  arma::lapack::gesdd(&jobz, &n, &n, work.EE.memptr(), &n, work.s.memptr(),
+                      work.U.memptr(), &n, work.Vt.memptr(), &n, &query,
+                      &lwork, work.iwork.memptr(), &info) ;
+  if (info != 0) {
+    return(false) ;
+  }
+  lwork = std::max(arma::blas_int(query), 7 * n * n + 4 * n) ;
+  work.work.set_size(lwork) ;
+  arma::lapack::gesdd(&jobz, &n, &n, work.EE.memptr(), &n, work.s.memptr(),
+                      work.U.memptr(), &n, work.Vt.memptr(), &n,
+                      work.work.memptr(), &lwork, work.iwork.memptr(), &info) ;
+  return(info == 0) ;
+}
+
+/* factors, loadings and eigenvalues given error */
+void factor_extract (const arma::mat& E, int r, const FactorEngine& engine,
+                     arma::mat& factor, arma::mat& lambda, arma::mat& VNT,
+                     const arma::mat& factor0, FactorWork& work) {
+  int T = E.n_rows ;
+  int N = E.n_cols ;
+
+  if (factor_approx(E, r, engine, factor, lambda, VNT, factor0)) {
+    return ;
+  }
+
+  // single precision: the O(NT min(N, T)) gram product and the
+  // eigen decomposition in float, which halves the memory traffic
+  if (engine.precision == 1) {
+    factor_gram(arma::conv_to<arma::fmat>::from(E), r, factor, lambda, VNT) ;
+    return ;
+  }
+
+  // the gram matrix of the shorter side, and its svd, in work; the
+  // products are written straight into their buffers
+  if (T < N) {
+    work.EE = E * E.t() ;
+  }
+  else {
+    work.EE = E.t() * E ;
+  }
+  work.EE /= double(N) * T ;
+  if (!gram_svd(work)) { // empty, as after a failed arma::svd
+    work.U.reset() ;
+    work.s.reset() ;
+  }
+  if (T < N) {
+    factor = work.U.head_cols(r) * sqrt(double(T)) ;
+    lambda = E.t() * factor ;
+    lambda /= T ;
+  }
+  else {
+    lambda = work.U.head_cols(r) * sqrt(double(N)) ;
+    factor = E * lambda ;
+    factor /= N ;
+  }
+  VNT = diagmat(work.s.head_rows(r)) ;
+}
+
+void factor_extract (const arma::mat& E, int r, const FactorEngine& engine,
+                     arma::mat& factor, arma::mat& lambda, arma::mat& VNT,
+                     const arma::mat& factor0) {
+  FactorWork work ;
+  factor_extract(E, r, engine, factor, lambda, VNT, factor0, work) ;
+}
+
+/* sparse plus low-rank error: only the exact path forms it densely,
+   in work.D */
+void factor_extract (const SpLowRank& E, int r, const FactorEngine& engine,
+                     arma::mat& factor, arma::mat& lambda, arma::mat& VNT,
+                     const arma::mat& factor0, FactorWork& work) {
+  if (factor_approx(E, r, engine, factor, lambda, VNT, factor0)) {
+    return ;
+  }
+  work.D = E.S ;
+  if (E.A.n_cols > 0) {
+    work.D += E.A * E.B.t() ;
+  }
+  factor_extract(work.D, r, engine, factor, lambda, VNT, arma::mat(), work) ;
+}
+
+void factor_extract (const SpLowRank& E, int r, const FactorEngine& engine,
+                     arma::mat& factor, arma::mat& lambda, arma::mat& VNT,
+                     const arma::mat& factor0) {
+  FactorWork work ;
+  factor_extract(E, r, engine, factor, lambda, VNT, factor0, work) ;
+}
+
+
+/* ******************* Soft Thresholding  *********************** */
+
+/* dense T * N value of a low-rank matrix */
+arma::mat lowrank_dense (const LowRank& Z, int T, int N) {
+  if (Z.d.n_elem == 0) {
+    return(arma::zeros<arma::mat>(T, N)) ;
+  }
+  return(Z.U * diagmat(Z.d) * Z.V.t()) ;
+}
+
+/* entry (t, i) of a low-rank matrix */
+inline double lowrank_at (const LowRank& Z, arma::uword t, arma::uword i) {
+  double v = 0 ;
+  for (arma::uword k = 0; k < Z.d.n_elem; k++) {
+    v += Z.U(t, k) * Z.d(k) * Z.V(i, k) ;
+  }
+  return(v) ;
+}
+
+/* frobenius inner product of two low-rank matrices, O((T+N)k^2) */
+double lowrank_dot (const LowRank& A, const LowRank& B) {
+  if (A.d.n_elem == 0 || B.d.n_elem == 0) {
+    return(0.0) ;
+  }
+  arma::mat G = (A.U.t() * B.U) % (A.d * B.d.t()) ;
+  return(arma::accu(G % (A.V.t() * B.V))) ;
+}
+
+/* R of the qr of X, in the upper triangle of X (lapack dgeqrf, as
+   arma::qr_econ computes it), with tau and the workspace in buffers */
+void qr_r_into (arma::mat& X, arma::vec& tau, arma::vec& work) {
+  arma::blas_int m = X.n_rows ;
+  arma::blas_int n = X.n_cols ;
+  arma::blas_int info = 0 ;
+  if (m == 0 || n == 0) {
+    return ;
+  }
+  if (tau.n_elem < (arma::uword) std::min(m, n)) {
+    tau.set_size(std::min(m, n)) ;
+  }
+  double query = 0 ;
+  arma::blas_int lwork = -1 ;
+  arma::lapack::geqrf(&m, &n, X.memptr(), &m, tau.memptr(), &query, &lwork,
+                      &info) ;
+  lwork = std::max(arma::blas_int(query), n) ;
+  if (work.n_elem < (arma::uword) lwork) {
+    work.set_size(lwork) ;
+  }
+  lwork = work.n_elem ;
+  arma::lapack::geqrf(&m, &n, X.memptr(), &m, tau.memptr(), work.memptr(),
+                      &lwork, &info) ;
+}
+
+/* frobenius distance between two low-rank matrices, O((T+N)k^2).
+   A - B is the stacked factorization [A.U, B.U] diag(A.d, -B.d)
+   [A.V, B.V]'; with the qr factors of its two sides its norm is that
+   of the k * k matrix R_U diag(d) R_V'. Expanding |A|^2 + |B|^2 -
+   2<A,B> instead cancels, and cannot resolve steps below about
+   sqrt(eps) |A|. With an empty B, the norm of A */
+double lowrank_dist (const LowRank& A, const LowRank& B, DistWork& w) {
+  arma::uword ka = A.d.n_elem ;
+  arma::uword kb = B.d.n_elem ;
+  arma::uword k = ka + kb ;
+  if (k == 0) {
+    return(0.0) ;
+  }
+  arma::uword T = ka > 0 ? A.U.n_rows : B.U.n_rows ;
+  arma::uword N = ka > 0 ? A.V.n_rows : B.V.n_rows ;
+  w.U.set_size(T, k) ;
+  w.V.set_size(N, k) ;
+  if (ka > 0) {
+    w.U.head_cols(ka) = A.U ;
+    w.V.head_cols(ka) = A.V ;
+  }
+  if (kb > 0) {
+    w.U.tail_cols(kb) = B.U ;
+    w.V.tail_cols(kb) = B.V ;
+  }
+  qr_r_into(w.U, w.tau, w.work) ;
+  qr_r_into(w.V, w.tau, w.work) ;
+
+  // R_U (mu * k) and R_V (mv * k) are upper triangular
+  arma::uword mu = std::min(T, k) ;
+  arma::uword mv = std::min(N, k) ;
+  double ss = 0 ;
+  for (arma::uword j = 0; j < mv; j++) {
+    for (arma::uword i = 0; i < mu; i++) {
+      double v = 0 ;
+      for (arma::uword l = std::max(i, j); l < k; l++) {
+        double d = l < ka ? A.d(l) : -B.d(l - ka) ;
+        v += w.U(i, l) * d * w.V(j, l) ;
+      }
+      ss += v * v ;
+    }
+  }
+  return(sqrt(ss)) ;
+}
+
+double lowrank_dist (const LowRank& A, const LowRank& B) {
+  DistWork w ;
+  return(lowrank_dist(A, B, w)) ;
+}
+
+/* singular value soft-thresholding of E at lambda; Z holds the
+   previous solution on entry and the new one on exit. By default
+   (method 0) the triplets come from an exact economical svd. With
+   method = 1 only the triplets above lambda are computed: a
+   randomized partial svd starts from the previous rank and is doubled
+   until its smallest singular value drops below lambda; past half the
+   full rank the exact svd is cheaper. Its singular values are those
+   of a projection of E, so they never exceed the exact ones: every
+   value kept is exactly above lambda, though values close to lambda
+   may be missed */
+template <typename Op>
+void svt_extract (const Op& E, double lambda, int method, LowRank& Z) {
+  int T = op_rows(E) ;
+  int N = op_cols(E) ;
+  int m = std::min(T, N) ;
+  int k = Z.d.n_elem + 5 ;
+  bool exact = true ;
+  arma::mat U ;
+  arma::vec s ;
+  arma::mat V ;
+
+  while (method == 1 && 2 * k < m) {
+    if (!svd_rand(U, s, V, E, k, 10, 2)) {
+      break ;
+    }
+    if (s(k - 1) <= lambda) {
+      exact = false ;
+      break ;
+    }
+    k = 2 * k ;
+  }
+  if (exact) {
+    arma::svd_econ(U, s, V, op_dense(E)) ;
+  }
+
+  int q = 0 ; // singular values are sorted decreasingly
+  while (q < (int) s.n_elem && s(q) > lambda) {
+    q++ ;
+  }
+  Z.U = U.head_cols(q) ;
+  Z.d = s.head(q) - lambda ;
+  Z.V = V.head_cols(q) ;
+}
+
+/* ******************* Convergence  *********************** */
+
+/* the convergence measure of ctl: the loop's own scaled change
+   (legacy), or the change of the iterate, step, absolute or relative
+   to the iterate's norm, size */
+inline double conv_measure (const IterControl& ctl, double legacy,
+                            double step, double size) {
+  if (ctl.criterion == 1) {
+    return(step) ;
+  }
+  if (ctl.criterion == 2) {
+    return(step / std::max(size, 1e-10)) ;
+  }
+  return(legacy) ;
+}
+
+/* the iteration budget of a loop: max.iter if it was given; otherwise
+   the loop's own historical bound under the legacy criterion (500, or
+   501 for the loops that tested niter <= 500) and 500 under the others */
+inline int iter_budget (const IterControl& ctl, int legacy) {
+  if (ctl.max_iter > 0) {
+    return(ctl.max_iter) ;
+  }
+  return(ctl.criterion == 0 ? legacy : 500) ;
+}
+
+/* residual sum of squares of fit at the observed cells */
+inline double obs_ssr (const arma::mat& Y, const arma::mat& fit,
+                       const CellIndex& miss) {
+  arma::mat E = Y - fit ;
+  zero_cells(E, miss) ;
+  return(arma::accu(arma::square(E))) ;
+}
+
+/* wall time of the iterations of a trace */
+struct IterClock {
+  std::chrono::steady_clock::time_point t0 ;
+  IterClock () : t0(std::chrono::steady_clock::now()) {}
+  void reset () {
+    t0 = std::chrono::steady_clock::now() ;
+  }
+  double lap () const { // seconds since the last reset
+    std::chrono::duration<double> s = std::chrono::steady_clock::now() - t0 ;
+    return(s.count()) ;
+  }
+} ;
+
+inline void trace_push (IterTrace& trace, double objective, double step,
+                        double seconds) {
+  trace.objective.push_back(objective) ;
+  trace.step.push_back(step) ;
+  trace.time.push_back(seconds) ;
+}
+
+/* ******************* Acceleration  *********************** */
+
+/* SQUAREM (Varadhan and Roland, 2008) for the fixed-point loops below,
+   opt-in with accel = 1. A loop hands each new iterate to push(); of
+   three successive ones, x0, x1 = T(x0) and x2 = T(x1), it makes the
+   extrapolation
+     x' = x0 - 2 a (x1 - x0) + a^2 (x2 - 2 x1 + x0),
+   a = -|x1 - x0| / |x2 - 2 x1 + x0| (scheme 3), in [-step_max, -1],
+   and the loop takes its next step from x'. Should that step move
+   further than x1 -> x2 did, the extrapolation is undone: the loop
+   resumes from x2 and the bound on the step shrinks. A state type
+   only needs state_dot() and state_comb() below. */
+
+inline double state_dot (const arma::vec& a, const arma::vec& b) {
+  return(arma::dot(a, b)) ;
+}
+
+/* c(0) * x0 + c(1) * x1 + c(2) * x2 */
+inline arma::vec state_comb (const arma::vec& c, const arma::vec& x0,
+                             const arma::vec& x1, const arma::vec& x2) {
+  return(c(0) * x0 + c(1) * x1 + c(2) * x2) ;
+}
+
+/* additive fe (mu, alpha', xi')' and an interactive fe in factored form */
+struct FeLowRank {
+  arma::vec fe ;
+  LowRank G ;
+} ;
+
+inline double state_dot (const FeLowRank& a, const FeLowRank& b) {
+  return(arma::dot(a.fe, b.fe) + lowrank_dot(a.G, b.G)) ;
+}
+
+/* the low-rank terms are put side by side, each scaled by its
+   coefficient, so the combination stays in factored form */
+inline FeLowRank state_comb (const arma::vec& c, const FeLowRank& x0,
+                             const FeLowRank& x1, const FeLowRank& x2) {
+  FeLowRank x ;
+  x.fe = c(0) * x0.fe + c(1) * x1.fe + c(2) * x2.fe ;
+  x.G.U = arma::join_rows(x0.G.U, arma::join_rows(x1.G.U, x2.G.U)) ;
+  x.G.d = arma::join_cols(c(0) * x0.G.d,
+                          arma::join_cols(c(1) * x1.G.d, c(2) * x2.G.d)) ;
+  x.G.V = arma::join_rows(x0.G.V, arma::join_rows(x1.G.V, x2.G.V)) ;
+  return(x) ;
+}
+
+template <typename State>
+double state_dist (const State& a, const State& b) {
+  double d2 = state_dot(a, a) + state_dot(b, b) - 2 * state_dot(a, b) ;
+  return(sqrt(std::max(d2, 0.0))) ;
+}
+
+inline double state_dist (const arma::vec& a, const arma::vec& b) {
+  return(arma::norm(a - b)) ;
+}
+
+template <typename State>
+struct Squarem {
+  int on ;
+  int phase ;      // 0, 1, 2: iterates of the cycle so far; 3: extrapolated
+  double step_max ;
+  double res_ref ; // |x2 - x1|
+  double rate ;    // |x2 - x1| / |x1 - x0|, of the plain iteration
+  double saved ;   // estimated plain steps saved
+  State x0 ;
+  State x1 ;
+  State x2 ;
+  State xe ;
+  Squarem (int accel) : on(accel), phase(0), step_max(1), res_ref(0),
+                        rate(0), saved(0) {}
+  bool push (State& x) ;
+} ;
+
+/* hand over the latest iterate; true if x was replaced, in which
+   case the loop takes its state from x */
+template <typename State>
+bool Squarem<State>::push (State& x) {
+  if (on == 0) {
+    return(false) ;
+  }
+  if (phase == 0) {
+    x0 = x ;
+    phase = 1 ;
+    return(false) ;
+  }
+  if (phase == 1) {
+    x1 = x ;
+    phase = 2 ;
+    return(false) ;
+  }
+  if (phase == 2) {
+    x2 = x ;
+    const State* xs[3] = {&x0, &x1, &x2} ;
+    arma::mat K(3, 3) ; // gram matrix of x0, x1, x2
+    for (int i = 0; i < 3; i++) {
+      for (int j = 0; j <= i; j++) {
+        K(i, j) = state_dot(*xs[i], *xs[j]) ;
+        K(j, i) = K(i, j) ;
+      }
+    }
+    arma::vec c_r = {-1, 1, 0} ;
+    arma::vec c_v = {1, -2, 1} ;
+    arma::vec c_q = {0, -1, 1} ;
+    double r = sqrt(std::max(arma::dot(c_r, K * c_r), 0.0)) ;
+    double v = sqrt(std::max(arma::dot(c_v, K * c_v), 0.0)) ;
+    res_ref = sqrt(std::max(arma::dot(c_q, K * c_q), 0.0)) ;
+    if (r <= 0 || v <= 0) {
+      x0 = x2 ;
+      phase = 1 ;
+      return(false) ;
+    }
+    rate = res_ref / r ;
+    double a = std::max(std::min(-r / v, -1.0), -step_max) ;
+    if (a == -step_max) {
+      step_max = 4 * step_max ;
+    }
+    if (a == -1) { // x' = x2: nothing to undo
+      x0 = x2 ;
+      phase = 1 ;
+      return(false) ;
+    }
+    arma::vec c = {(1 + a) * (1 + a), -2 * a * (1 + a), a * a} ;
+    x = state_comb(c, x0, x1, x2) ;
+    xe = x ;
+    phase = 3 ;
+    return(true) ;
+  }
+  // x = T(x'): keep the extrapolation if it did not lose ground
+  double res = state_dist(x, xe) ;
+  if (res <= res_ref) {
+    if (rate > 0 && rate < 1 && res > 0 && res_ref > 0) {
+      // plain steps from x2 to the same residual, less the one taken
+      saved += std::max(log(res / res_ref) / log(rate) - 1, 0.0) ;
+    }
+    x0 = x ;
+    phase = 1 ;
+    return(false) ;
+  }
+  step_max = std::max(1.0, step_max / 4) ;
+  x = x2 ;
+  x0 = x2 ;
+  phase = 1 ;
+  return(true) ;
+}
 
 
 /* ******************* Subsidiary Functions  *********************** */
 
 /* Obtain OLS panel estimate */
 // [[Rcpp::export]]
-arma::mat panel_est (arma::cube X, arma::mat Y, arma::mat MF) {
+arma::mat panel_est (const arma::cube& X, const arma::mat& Y,
+                     const arma::mat& MF) {
+  int T = X.n_rows ;
+  int N = X.n_cols ;
   int p = X.n_slices ;
-  arma::mat xx(p, p, arma::fill::zeros);
-  arma::mat xy(p, 1, arma::fill::zeros);
-  if (p==1) {
-    xx(0,0) = trace(X.slice(0).t() * MF * X.slice(0)) ;
-    xy(0,0) = trace(X.slice(0).t() * MF * Y) ;
-  }
-  if (p>1) {
-    for (int k = 0; k < p; k++) {
-      arma::mat MFX1 = MF * X.slice(k) ;
-      xy(k, 0) = trace(crossprod(MFX1, Y)) ;
-      for (int m = k; m < p; m++) {
-        arma::mat MFX2 = MF * X.slice(m) ;
-        xx(k, m) = trace(crossprod(MFX1, MFX2)) ;
-        if (k < m) {
-          xx(m, k) = xx(k, m) ;
-        }
-      }
-    }
-  }
-  return(xx.i() * xy) ;
+  // the cube as T * (N p): MF * X_k for all k in one gemm
+  const arma::mat Xw(const_cast<double*>(X.memptr()), T, N * p, false, true) ;
+  arma::mat MFX = MF * Xw ;
+  // ... and the result as the NT * p design of MF * X_k
+  const arma::mat MFXd(MFX.memptr(), T * N, p, false, true) ;
+  const arma::vec y(const_cast<double*>(Y.memptr()), Y.n_elem, false, true) ;
+  arma::mat xx = MFXd.t() * MFXd ; // tr(X_k' MF' MF X_m); syrk
+  arma::mat xy = MFXd.t() * y ;   // tr(X_k' MF' Y); gemv
+  arma::mat beta ;
+  gram_solve(beta, gram_factor(xx), xy) ;
+  return(beta) ;
 }
 
 /* Obtain beta given interactive fe */
 // [[Rcpp::export]]
-arma::mat panel_beta (arma::cube X, arma::mat xxinv,
-                      arma::mat Y, arma::mat FE) {
-  int p = X.n_slices ; 
-  arma::mat xy(p, 1, arma::fill::zeros) ;
-  for (int k = 0; k < p; k++) {
-    xy(k) = trace(crossprod(X.slice(k), (Y - FE))) ;
-  }
-  return(xxinv * xy);
+arma::mat panel_beta (const arma::cube& X, const arma::mat& xxinv,
+                      const arma::mat& Y, const arma::mat& FE) {
+  arma::mat beta ;
+  panel_beta_into(beta, X, gram_inverse(xxinv), Y - FE) ;
+  return(beta);
 }
 
 /* Obtain factors and loading given error */
 // [[Rcpp::export]]
-List panel_factor (arma::mat E, int r) {
+List panel_factor (const arma::mat& E, int r,
+                   int svd_method = 0, // 0: exact; 1: randomized; 2: warm
+                   int oversample = 10,
+                   int power = 2) {
   int T = E.n_rows ;
   int N = E.n_cols ;
   arma::mat factor(T, r, arma::fill::zeros) ;
   arma::mat lambda(N, r, arma::fill::zeros) ;
   arma::mat FE (T, N, arma::fill::zeros) ;
   arma::mat VNT(r, r, arma::fill::zeros) ;
-  arma::mat U ;
-  arma::vec s ;
-  arma::mat V ; 
-  if (T < N) { 
-    arma::mat EE = E * E.t() /(N * T) ;
-    arma::svd( U, s, V, EE) ;
-    factor = U.head_cols(r) * sqrt(double(T)) ;
-    lambda = E.t() * factor/T ;
-    VNT = diagmat(s.head_rows(r)) ;
-  } 
-  else {
-    arma::mat EE = E.t() * E / (N * T) ;
-    svd(U, s, V, EE) ;
-    lambda = U.head_cols(r) * sqrt(double(N)) ;
-    factor = E * lambda / N ;
-    VNT = diagmat(s.head_rows(r)) ;
-  }
+  FactorEngine engine = {svd_method, oversample, power} ;
+  factor_extract(E, r, engine, factor, lambda, VNT, arma::mat()) ;
   FE = factor * lambda.t() ;
   List result ;
   result["lambda"] = lambda ;
@@ -312,91 +1384,86 @@ List panel_factor (arma::mat E, int r) {
 /* Obtain factors and loading given error for ub data,
    useless under the assumption of non-zero grandmean */
 // [[Rcpp::export]]
-List panel_factor_ub (arma::mat E, arma::mat I, int r, double tolerate) {
+List panel_factor_ub (const arma::mat& E, const arma::mat& I, int r, double tolerate,
+                       int svd_method = 0,
+                       int oversample = 10,
+                       int power = 2,
+                       int accel = 0,
+                       Rcpp::Nullable<Rcpp::List> control = R_NilValue // see iter_control
+                       ) {
   int T = E.n_rows ;
   int N = E.n_cols ;
   int niter = 0;
   double dif = 1.0 ;
   arma::mat F(T, r, arma::fill::zeros) ;
-  arma::mat F_old(N, r, arma::fill::zeros) ;
+  arma::mat F_old(T, r, arma::fill::zeros) ;
   arma::mat L(N, r, arma::fill::zeros) ;
   arma::mat L_old(N, r, arma::fill::zeros) ;
   arma::mat FE_0(T, N, arma::fill::zeros) ; // intermediate value
   arma::mat FE(T, N, arma::fill::zeros) ;
   arma::mat E_use(T, N, arma::fill::zeros) ; // intermediate value
   arma::mat VNT(r, r, arma::fill::zeros) ;
+  FactorEngine engine = {svd_method, oversample, power} ;
+  IterControl ctl = iter_control(tolerate, control) ;
+  CellIndex miss = cell_index(I, false) ;
+  Squarem<arma::vec> acc(accel) ; // on the fit at missing cells
+  FactorWork fwork ;
 
-  List pf = panel_factor(E, r)  ;
-  F = as<arma::mat>(pf["factor"]) ;
-  L = as<arma::mat>(pf["lambda"]) ;
+  factor_extract(E, r, engine, F, L, VNT, arma::mat(), fwork) ;
 
-  while ( (niter<500) && (dif>tolerate) ) {
+  E_use = E ;
+  FE_0 = F * L.t() ; 
+  while ( (niter < iter_budget(ctl, 500)) && (dif > ctl.tol) ) {
     niter++ ;
-    FE_0 = F * L.t() ; 
-    E_use = E_adj(E, FE_0, I) ; // e-step
-    pf = panel_factor(E_use, r)  ; // m-step
-    F = as<arma::mat>(pf["factor"]) ;
-    L = as<arma::mat>(pf["lambda"]) ;
-    VNT = as<arma::mat>(pf["VNT"]) ;
+    fill_cells(E_use, FE_0, miss) ; // e-step
+    factor_extract(E_use, r, engine, F, L, VNT, F, fwork) ; // m-step, warm from F
     if (T<N) { // factor : projection matrix
-      dif = arma::norm(F - F_old, "fro")/(r*T) ;
+      double step = arma::norm(F - F_old, "fro") ;
+      dif = conv_measure(ctl, step/(r*T), step, arma::norm(F, "fro")) ;
       F_old = F ;
     } else { // lambda : projection matrix
-      dif = arma::norm(L - L_old, "fro")/(r*N) ;
+      double step = arma::norm(L - L_old, "fro") ;
+      dif = conv_measure(ctl, step/(r*N), step, arma::norm(L, "fro")) ;
       L_old = L ;      
     }
+    FE_0 = F * L.t() ; 
+    if (acc.on == 1 && dif > ctl.tol) {
+      arma::vec x = cells_of(FE_0, miss) ;
+      if (acc.push(x)) {
+        set_cells(FE_0, x, miss) ;
+      }
+    }
   }
   FE = FE_adj(F*L.t(), I) ;
 
-  List result ;
-  result["niter"] = niter ;
-  result["lambda"] = L ;
-  result["factor"] = F ;
-  result["VNT"] = VNT ;
-  result["FE"] = FE ;
-  return(result) ;
-}
-
-/* Obtain interactive fe directly */
-// [[Rcpp::export]]
-arma::mat panel_FE (arma::mat E, double lambda) {
-  int T = E.n_rows ;
-  int N = E.n_cols ;
-  int r = T ;
-  if (T >= N) {
-    r = N ;
-  }
-
-  arma::mat FE (T, N, arma::fill::zeros) ;
-  arma::mat D(r, r, arma::fill::zeros) ;
-  arma::mat U ;
-  arma::vec s ;
-  arma::mat V ;
-  arma::svd( U, s, V, E) ;
-  
-  for (int i = 0; i < r; i++) {
-    if (s(i) > lambda) {
-      D(i, i) = s(i) - lambda ;
-    } else {
-      D(i, i) = 0 ;
-    }
-  }
-  if (T >= N) {
-    arma::mat UU = U.cols(0, r-1) ; 
-    FE = UU * D * V.t() ;
-  }
-  else {
-    arma::mat VV = V.cols(0, r-1) ;
-    FE = U * D * VV.t() ;
+  List result ;
+  result["niter"] = niter ;
+  if (accel == 1) {
+    result["niter.saved"] = acc.saved ;
   }
-  return(FE) ;
+  result["lambda"] = L ;
+  result["factor"] = F ;
+  result["VNT"] = VNT ;
+  result["FE"] = FE ;
+  return(result) ;
+}
+
+/* Obtain interactive fe directly */
+// [[Rcpp::export]]
+arma::mat panel_FE (const arma::mat& E, double lambda,
+                    int svd_method = 0 // 0: exact; 1: randomized, see svt_extract
+                    ) {
+  LowRank Z ;
+  svt_extract(E, lambda, svd_method, Z) ;
+  return(lowrank_dense(Z, E.n_rows, E.n_cols)) ;
 }
 
 /* Obtain interactive fe directly: matrix completion,
    useless under the assumption of non-zero grandmean */
 // [[Rcpp::export]]
-List panel_FE_ub (arma::mat E, arma::mat I, // I: indicator matrix
-                double lambda, double tolerate) {
+List panel_FE_ub (const arma::mat& E, const arma::mat& I, // I: indicator matrix
+                double lambda, double tolerate, int accel = 0,
+                int svd_method = 0) { // 0: exact; 1: randomized, see svt_extract
   int T = E.n_rows ;
   int N = E.n_cols ;
   //int r = T ;
@@ -406,121 +1473,371 @@ List panel_FE_ub (arma::mat E, arma::mat I, // I: indicator matrix
   double dif = 1.0 ;
   int niter = 0 ;
 
-  arma::mat FE_m (T, N, arma::fill::zeros) ; // the missing matrix
-  arma::mat FE (T, N, arma::fill::zeros) ;
-  arma::mat FE_old = E ;
+  // E plus the fit at missing cells is kept as the sparse observed
+  // residual E - Z plus Z itself, so no T * N matrix is formed
+  CellIndex obs = cell_index(I, true) ;
+  CellIndex miss = cell_index(I, false) ;
+  arma::vec E_miss(miss.loc.n_cols) ;
+  for (arma::uword k = 0; k < miss.loc.n_cols; k++) {
+    E_miss(k) = E(miss.loc(0, k), miss.loc(1, k)) ;
+  }
+  arma::sp_mat S_miss(miss.loc, E_miss, T, N, false, true) ; // usually empty
+  arma::vec res(obs.loc.n_cols) ;
+  SpLowRank EE ;
+  LowRank Z ;
+  LowRank Z_old ;
+  // accelerated, the fill of the missing cells, z, may differ from Z
+  // there; the sparse part then carries z - Z at missing cells
+  Squarem<arma::vec> acc(accel) ;
+  arma::vec z(miss.loc.n_cols, arma::fill::zeros) ;
+  arma::vec adj(miss.loc.n_cols) ;
   
-  // arma::mat EE = E; // replicate data
   while ((dif > tolerate) && (niter < 500)) {
     niter++ ;
-    FE = panel_FE(E + FE_m, lambda) ;
-    FE_m = FE_missing(FE, I) ;
-    dif = arma::norm(FE - FE_old, "fro")/(N*T) ;
-    FE_old = FE ;
+    for (arma::uword k = 0; k < obs.loc.n_cols; k++) {
+      res(k) = E(obs.loc(0, k), obs.loc(1, k))
+        - lowrank_at(Z, obs.loc(0, k), obs.loc(1, k)) ;
+    }
+    if (acc.on == 1) {
+      for (arma::uword k = 0; k < miss.loc.n_cols; k++) {
+        adj(k) = E_miss(k) + z(k) - lowrank_at(Z, miss.loc(0, k), miss.loc(1, k)) ;
+      }
+      EE.S = arma::sp_mat(obs.loc, res, T, N, false, false)
+        + arma::sp_mat(miss.loc, adj, T, N, false, false) ;
+    } else {
+      EE.S = arma::sp_mat(obs.loc, res, T, N, false, false) + S_miss ;
+    }
+    EE.A = Z.U * diagmat(Z.d) ;
+    EE.B = Z.V ;
+    svt_extract(EE, lambda, svd_method, Z) ;
+    dif = lowrank_dist(Z, Z_old)/(N*T) ;
+    Z_old = Z ;
+    if (acc.on == 1 && dif > tolerate) {
+      for (arma::uword k = 0; k < miss.loc.n_cols; k++) {
+        z(k) = lowrank_at(Z, miss.loc(0, k), miss.loc(1, k)) ;
+      }
+      acc.push(z) ;
+    }
   }
   List out ;
   out["niter"] = niter ;
-  out["FE"] = FE ;
+  if (accel == 1) {
+    out["niter.saved"] = acc.saved ;
+  }
+  out["FE"] = lowrank_dense(Z, T, N) ;
   return(out) ;
 }
 
 
+/* Additive fe from the observed cells alone. The em below converges
+   to the least squares fit of mu + alpha_i + xi_t over the observed
+   cells, normalized to sum(alpha) = sum(xi) = 0; this solves for it
+   directly on the compressed list of observed cells. One-way effects
+   are observed means. For two-way effects, write the fit as
+   a_i + b_t; profiling out a_i = (s_i - sum_{t in O_i} b_t) / n_i
+   leaves the normal equations
+     (D_m - W D_n^{-1} W') b = r - W D_n^{-1} s
+   in the time effects, W the T * N indicator, s, n (r, m) the observed
+   sums and counts of the units (periods). The system is a graph
+   laplacian of the observation pattern, so conjugate gradients
+   (preconditioned by D_m) from b = 0 converge in a few sweeps over the
+   observed cells, where the em needs many passes over all T * N.
+   Assumes every unit (period) with an effect has an observed cell. */
+/* a_i = (s_i - sum_{t in O_i} b_t) / n_i */
+void masked_unit_fe (arma::vec& a, const arma::vec& b, const arma::vec& s,
+                     const arma::vec& n, const CellIndex& obs) {
+  for (arma::uword i = 0; i < a.n_elem; i++) {
+    double sb = 0 ;
+    for (arma::uword k = obs.colptr(i); k < obs.colptr(i + 1); k++) {
+      sb += b(obs.loc(0, k)) ;
+    }
+    a(i) = (s(i) - sb) / n(i) ;
+  }
+}
+
+/* q = (D_m - W D_n^{-1} W') p; w is an N-vector buffer */
+void masked_laplace (arma::vec& q, const arma::vec& p, const arma::vec& n,
+                     const arma::vec& m, const CellIndex& obs, arma::vec& w) {
+  for (arma::uword i = 0; i < w.n_elem; i++) {
+    double sp = 0 ;
+    for (arma::uword k = obs.colptr(i); k < obs.colptr(i + 1); k++) {
+      sp += p(obs.loc(0, k)) ;
+    }
+    w(i) = sp / n(i) ;
+  }
+  q = m % p ;
+  for (arma::uword k = 0; k < obs.loc.n_cols; k++) {
+    q(obs.loc(0, k)) -= w(obs.loc(1, k)) ;
+  }
+}
+
+/* residual sum of squares of mu + a_i + b_t at the observed cells */
+double masked_ssr (const arma::mat& Y, double mu, const arma::vec& a,
+                   const arma::vec& b, const CellIndex& obs) {
+  double ssr = 0 ;
+  for (arma::uword k = 0; k < obs.loc.n_cols; k++) {
+    arma::uword t = obs.loc(0, k) ;
+    arma::uword i = obs.loc(1, k) ;
+    double e = Y(t, i) - mu - a(i) - b(t) ;
+    ssr += e * e ;
+  }
+  return(ssr) ;
+}
+
+IterFit fe_masked_core (const arma::mat& Y,
+                        const arma::mat& I,
+                        int force,
+                        const IterControl& ctl) {
+  int T = Y.n_rows ;
+  int N = Y.n_cols ;
+  CellIndex obs = cell_index(I, true) ;
+  arma::uword n_obs = obs.loc.n_cols ;
+
+  arma::vec s(N, arma::fill::zeros) ; // unit sums and counts
+  arma::vec n(N, arma::fill::zeros) ;
+  arma::vec r(T, arma::fill::zeros) ; // period sums and counts
+  arma::vec m(T, arma::fill::zeros) ;
+  for (arma::uword k = 0; k < n_obs; k++) {
+    arma::uword t = obs.loc(0, k) ;
+    arma::uword i = obs.loc(1, k) ;
+    double y = Y(t, i) ;
+    s(i) += y ;
+    n(i) += 1 ;
+    r(t) += y ;
+    m(t) += 1 ;
+  }
+
+  double mu = 0 ;
+  arma::vec a(N, arma::fill::zeros) ;
+  arma::vec b(T, arma::fill::zeros) ;
+  int niter = 1 ;
+  IterTrace iters ;
+  IterClock clock ;
+
+  if (force == 0) {
+    mu = accu(s) / n_obs ;
+  }
+  if (force == 1) {
+    a = s / n ;
+  }
+  if (force == 2) {
+    b = r / m ;
+  }
+  if (force == 3) {
+    /* preconditioned conjugate gradients from b = 0 */
+    arma::vec g = r ; // r - W D_n^{-1} s
+    for (arma::uword k = 0; k < n_obs; k++) {
+      g(obs.loc(0, k)) -= s(obs.loc(1, k)) / n(obs.loc(1, k)) ;
+    }
+    arma::vec res = g ;
+    arma::vec z = res / m ;
+    arma::vec p = z ;
+    arma::vec q(T) ;
+    arma::vec w(N) ;
+    double rz = arma::dot(res, z) ;
+    double dif = 1.0 ;
+    niter = 0 ;
+    while (dif > ctl.tol && niter < iter_budget(ctl, 500) && rz > 0) {
+      masked_laplace(q, p, n, m, obs, w) ;
+      double pq = arma::dot(p, q) ;
+      if (pq <= 0) {
+        break ; // p is in the null space: b is exact
+      }
+      double len = rz / pq ;
+      b += len * p ;
+      res -= len * q ;
+      niter = niter + 1 ;
+
+      double step = std::abs(len) * arma::norm(p) ;
+      dif = conv_measure(ctl, step / T, step, arma::norm(b)) ;
+      if (ctl.trace == 1) {
+        double seconds = clock.lap() ;
+        masked_unit_fe(a, b, s, n, obs) ;
+        trace_push(iters, masked_ssr(Y, 0, a, b, obs), dif, seconds) ;
+        clock.reset() ;
+      }
+
+      z = res / m ;
+      double rz_new = arma::dot(res, z) ;
+      p = z + (rz_new / rz) * p ;
+      rz = rz_new ;
+    }
+    masked_unit_fe(a, b, s, n, obs) ;
+  }
+  else if (ctl.trace == 1) {
+    trace_push(iters, masked_ssr(Y, mu, a, b, obs), 0, clock.lap()) ;
+  }
+
+  /* normalize to sum(alpha) = sum(xi) = 0 */
+  IterFit est ;
+  est.fe.mu = mu + arma::mean(a) + arma::mean(b) ;
+  est.fe.alpha = a - arma::mean(a) ;
+  est.fe.xi = b - arma::mean(b) ;
+  est.fit = fe_add_dense(est.fe, T, N) ;
+  est.e = Y - est.fit ;
+  zero_cells(est.e, cell_index(I, false)) ;
+  est.niter = niter ;
+  est.trace = iters ;
+  return(est) ;
+}
+
 /* Obtain additive fe for ub data; assume r=0, without covar */
-// [[Rcpp::export]]
-List fe_ad_iter (arma::mat Y,
-                 arma::mat I,
-                 int force,
-                 double tolerate) {
+IterFit fe_ad_iter_core (const arma::mat& Y,
+                         const arma::mat& I,
+                         int force,
+                         const IterControl& ctl) {
   
   int T = Y.n_rows ;
   int N = Y.n_cols ;
+
+  // solve directly unless an effect has no observed cell, where
+  // it is not identified and the em is kept
+  arma::umat O = (I != 0) ;
+  arma::urowvec n_unit = sum(O, 0) ;
+  arma::uvec n_time = sum(O, 1) ;
+  bool empty = arma::accu(O) == 0 ;
+  if ((force == 1 || force == 3) && n_unit.min() == 0) {
+    empty = true ;
+  }
+  if ((force == 2 || force == 3) && n_time.min() == 0) {
+    empty = true ;
+  }
+  if (!empty) {
+    return(fe_masked_core(Y, I, force, ctl)) ;
+  }
   double mu = 0 ;
   double mu_old = 0 ;
   double dif = 1.0 ;
   int niter = 0 ;
 
-  arma::mat fit(T, N, arma::fill::zeros) ;
   arma::mat alpha(N, 1, arma::fill::zeros) ;
   arma::mat xi(T, 1, arma::fill::zeros) ;
   arma::mat alpha_old(N, 1, arma::fill::zeros) ;
   arma::mat xi_old(T, 1, arma::fill::zeros) ;
-  double mu_Y = 0 ;
-  arma::mat alpha_Y(N, 1, arma::fill::zeros) ;
-  arma::mat xi_Y(T, 1, arma::fill::zeros) ;
-
-  arma::mat YY = Y ;
-
-  List Y_ad ;
-  List Y_fe_ad ;
-
-  while (dif > tolerate && niter <= 500) {
 
-    YY =  E_adj (Y, fit, I) ; // e step: expeactation
-
-    Y_ad = Y_demean(YY, force) ;
-    
-    mu_Y = as<double>(Y_ad["mu_Y"]) ;
-    if (force==1||force==3) {     
-      alpha_Y = as<arma::mat>(Y_ad["alpha_Y"]) ;
-    }
-    if (force==2||force==3) {
-      xi_Y = as<arma::mat>(Y_ad["xi_Y"]) ;
+  // the completed panel is Y at observed cells and the fit at
+  // missing ones; only its row and column sums are needed, so
+  // the e step just adds the fit over the missing cells
+  CellIndex miss = cell_index(I, false) ;
+  arma::mat Y_obs = FE_adj(Y, I) ;
+  arma::mat rs_Y = sum(Y_obs, 1) ;
+  arma::mat cs_Y = sum(Y_obs, 0).t() ;
+  arma::mat rs(T, 1) ;
+  arma::mat cs(N, 1) ;
+  Squarem<arma::vec> acc(ctl.accel) ; // on (mu, alpha', xi')'
+  IterTrace iters ;
+  IterClock clock ;
+
+  while (dif > ctl.tol && niter < iter_budget(ctl, 501)) {
+
+    rs = rs_Y ; // e step: expeactation
+    cs = cs_Y ;
+    for (int i = 0; i < N; i++) {
+      for (arma::uword k = miss.colptr(i); k < miss.colptr(i + 1); k++) {
+        arma::uword t = miss.loc(0, k) ;
+        double v = mu + alpha(i) + xi(t) ;
+        rs(t) += v ;
+        cs(i) += v ;
+      }
     }
-    Y_fe_ad = fe_add2(alpha_Y, xi_Y, mu_Y, T, N, force) ; // m step: estimate fe
-    
-    fit = as<arma::mat>(Y_fe_ad["FE_ad"]) ;
 
-    mu = as<double>(Y_fe_ad["mu"]) ;
+    fe_add_sums(rs, cs, force, mu, alpha, xi) ; // m step: estimate fe
+
+    double legacy = 0 ;
     if (force == 0) {
-      dif = mu - mu_old ;
-      mu_old = mu ;
+      legacy = mu - mu_old ;
     }
     if ( force == 1 || force == 3 ) {
-      alpha = as<arma::mat>(Y_fe_ad["alpha"]) ;
-      dif = arma::norm(alpha - alpha_old, "fro")/N ;
-      alpha_old = alpha ; 
+      legacy = arma::norm(alpha - alpha_old, "fro")/N ;
     }
     if ( force == 2 ) {
-      xi = as<arma::mat>(Y_fe_ad["xi"]) ;
-      dif = arma::norm(xi - xi_old, "fro")/T ;
-      xi_old = xi ;
+      legacy = arma::norm(xi - xi_old, "fro")/T ;
     }
+    double step = sqrt(pow(mu - mu_old, 2)
+                       + arma::accu(arma::square(alpha - alpha_old))
+                       + arma::accu(arma::square(xi - xi_old))) ;
+    double size = sqrt(mu * mu + arma::accu(arma::square(alpha))
+                       + arma::accu(arma::square(xi))) ;
+    dif = conv_measure(ctl, legacy, step, size) ;
+    mu_old = mu ;
+    alpha_old = alpha ; 
+    xi_old = xi ;
 
     niter = niter + 1 ;
+
+    if (ctl.trace == 1) {
+      double seconds = clock.lap() ;
+      AddFE fe = {mu, alpha, xi} ;
+      trace_push(iters, obs_ssr(Y, fe_add_dense(fe, T, N), miss), dif,
+                 seconds) ;
+      clock.reset() ;
+    }
+
+    if (acc.on == 1 && dif > ctl.tol) {
+      arma::vec x = arma::join_cols(arma::vec({mu}),
+                                    arma::join_cols(arma::vectorise(alpha),
+                                                    arma::vectorise(xi))) ;
+      if (acc.push(x)) {
+        mu = x(0) ;
+        alpha = x.subvec(1, N) ;
+        xi = x.subvec(N + 1, N + T) ;
+        mu_old = mu ;
+        alpha_old = alpha ;
+        xi_old = xi ;
+      }
+    }
   }
 
-  arma::mat e = YY - fit ;
-  e = FE_adj(e, I) ;
+  IterFit est ;
+  est.fe.mu = mu ;
+  est.fe.alpha = alpha ;
+  est.fe.xi = xi ;
+  est.fit = fe_add_dense(est.fe, T, N) ;
+  est.e = Y - est.fit ;
+  zero_cells(est.e, miss) ;
+  est.niter = niter ;
+  est.saved = acc.saved ;
+  est.trace = iters ;
+  return(est) ;
+}
 
+// [[Rcpp::export]]
+List fe_ad_iter (const arma::mat& Y,
+                 const arma::mat& I,
+                 int force,
+                 double tolerate,
+                 int accel = 0) {
+  IterControl ctl = iter_control(tolerate) ;
+  ctl.accel = accel ;
+  IterFit est = fe_ad_iter_core(Y, I, force, ctl) ;
   List result;
-  result["mu"] = as<double>(Y_fe_ad["mu"]) ;
-  result["fit"] = fit ;
-  result["niter"] = niter ;
-  result["e"] = e ;
+  result["mu"] = est.fe.mu ;
+  result["fit"] = est.fit ;
+  result["niter"] = est.niter ;
+  if (accel == 1) {
+    result["niter.saved"] = est.saved ;
+  }
+  result["e"] = est.e ;
 
   if (force==1||force==3) {
-    alpha = as<arma::mat>(Y_fe_ad["alpha"]) ;
-    result["alpha"] = alpha ;
+    result["alpha"] = est.fe.alpha ;
   }
   if (force==2||force==3) {
-    xi = as<arma::mat>(Y_fe_ad["xi"]) ;
-    result["xi"] = xi ;
+    result["xi"] = est.fe.xi ;
   }
   return(result) ;
 }
 
-
 /* Obtain additive fe for ub data; assume r=0, with covariates */
-// [[Rcpp::export]]
-List fe_ad_covar_iter (arma::cube XX,
-                       arma::mat xxinv,
-                       arma::mat alpha_X,
-                       arma::mat xi_X,
-                       arma::mat mu_X,
-                       arma::mat Y,
-                       arma::mat I,
-                       int force,
-                       double tolerate) {
+IterFit fe_ad_covar_iter_core (const arma::cube& XX,
+                               const GramSolver& gram,
+                               const arma::mat& alpha_X,
+                               const arma::mat& xi_X,
+                               const arma::mat& mu_X,
+                               const arma::mat& Y,
+                               const arma::mat& I,
+                               int force,
+                               const IterControl& ctl) {
   int T = Y.n_rows ;
   int N = Y.n_cols ;
   int p = XX.n_slices ;
@@ -528,8 +1845,6 @@ List fe_ad_covar_iter (arma::cube XX,
   int niter = 0 ;
 
   arma::mat fit(T, N, arma::fill::zeros) ;
-  arma::mat alpha(N, 1, arma::fill::zeros) ;
-  arma::mat xi(T, 1, arma::fill::zeros) ;
   double mu_Y = 0 ;
   arma::mat alpha_Y(N, 1, arma::fill::zeros) ;
   arma::mat xi_Y(T, 1, arma::fill::zeros) ;
@@ -538,205 +1853,329 @@ List fe_ad_covar_iter (arma::cube XX,
   arma::mat YY_demean(T, N, arma::fill::zeros) ;
   arma::mat beta(p, 1, arma::fill::zeros) ;
   arma::mat beta_old = beta ;
+  CellIndex miss = cell_index(I, false) ;
+  Squarem<arma::vec> acc(ctl.accel) ; // on the fit at missing cells
+  IterTrace iters ;
+  IterClock clock ;
 
-  List Y_ad ;
-  List Y_fe_ad ;
-
-  while (dif > tolerate && niter <= 500) {
+  while (dif > ctl.tol && niter < iter_budget(ctl, 501)) {
 
-    YY =  E_adj (Y, fit, I) ; // e-step: expectation
-    Y_ad = Y_demean(YY, force) ;
+    fill_cells(YY, fit, miss) ; // e-step: expectation
+    YY_demean = YY ;
+    demean_into(YY_demean, mu_Y, alpha_Y, xi_Y, force) ;
+    panel_beta_into(beta, XX, gram, YY_demean) ; // m-step 
     
-    YY_demean = as<arma::mat>(Y_ad["YY"]) ;
-    beta = panel_beta(XX, xxinv, YY_demean, arma::zeros<arma::mat>(T,N)) ; // m-step 
-    
-    mu_Y = as<double>(Y_ad["mu_Y"]) ;
-    if (force==1||force==3) {     
-      alpha_Y = as<arma::mat>(Y_ad["alpha_Y"]) ;
-    }
-    if (force==2||force==3) {
-      xi_Y = as<arma::mat>(Y_ad["xi_Y"]) ;
-    }
-    Y_fe_ad = fe_add(alpha_X, xi_X, mu_X, alpha_Y, xi_Y, mu_Y, 
-                     beta, T, N, p, force) ;
     // fitted values
-    fit.zeros() ;
-    for (int i =0; i < p; i++) {
-        fit = fit + XX.slice(i) * beta(i) ;
-    }
-    if (force == 0) {
-      fit = fit + mu_Y ;
-    }
-    if (force == 1) {
-      fit = fit + repmat(alpha_Y.t(), T, 1) ;
-    }
-    if (force == 2) {
-      fit = fit + repmat(xi_Y, 1, N) ;
-    }
-    if (force == 3) {
-      fit = fit + repmat(alpha_Y.t(), T, 1) + repmat(xi_Y, 1, N) - mu_Y ;
-    }
+    covar_fit_into(fit, XX, beta) ;
+    remean_into(fit, mu_Y, alpha_Y, xi_Y, force) ;
     
-    dif = arma::norm(beta - beta_old, "fro")/p ;
+    double step = arma::norm(beta - beta_old, "fro") ;
+    dif = conv_measure(ctl, step/p, step, arma::norm(beta, "fro")) ;
     beta_old = beta ;
 
     niter = niter + 1 ;
-  }
 
-  arma::mat e = YY - fit ;
-  e = FE_adj(e, I) ;
+    if (ctl.trace == 1) {
+      double seconds = clock.lap() ;
+      trace_push(iters, obs_ssr(YY, fit, miss), dif, seconds) ;
+      clock.reset() ;
+    }
+
+    if (acc.on == 1 && dif > ctl.tol) {
+      arma::vec x = cells_of(fit, miss) ;
+      if (acc.push(x)) {
+        set_cells(fit, x, miss) ;
+      }
+    }
+  }
+  IterFit est ;
+  est.fe = fe_add_core(alpha_X, xi_X, mu_X, alpha_Y, xi_Y, mu_Y, 
+                       beta, T, N, force) ;
+  est.beta = beta ;
+  est.e = YY - fit ;
+  zero_cells(est.e, miss) ;
+  est.fit = fit ;
+  est.niter = niter ;
+  est.saved = acc.saved ;
+  est.trace = iters ;
+  return(est) ;
+}
 
+// [[Rcpp::export]]
+List fe_ad_covar_iter (const arma::cube& XX,
+                       const arma::mat& xxinv,
+                       const arma::mat& alpha_X,
+                       const arma::mat& xi_X,
+                       const arma::mat& mu_X,
+                       const arma::mat& Y,
+                       const arma::mat& I,
+                       int force,
+                       double tolerate,
+                       int accel = 0,
+                       Rcpp::Nullable<Rcpp::List> control = R_NilValue // see iter_control
+                       ) {
+  IterControl ctl = iter_control(tolerate, control) ;
+  ctl.accel = accel ;
+  IterFit est = fe_ad_covar_iter_core(XX, gram_inverse(xxinv),
+                                      alpha_X, xi_X, mu_X,
+                                      Y, I, force, ctl) ;
   List result;
-  result["mu"] = as<double>(Y_fe_ad["mu"]) ;
-  result["fit"] = fit ;
-  result["niter"] = niter ;
-  result["e"] = e ;
-  if (p>0) {
-    result["beta"] = beta ;
+  result["mu"] = est.fe.mu ;
+  result["fit"] = est.fit ;
+  result["niter"] = est.niter ;
+  if (accel == 1) {
+    result["niter.saved"] = est.saved ;
+  }
+  result["e"] = est.e ;
+  if (XX.n_slices > 0) {
+    result["beta"] = est.beta ;
   }
   if (force==1||force==3) {
-    alpha = as<arma::mat>(Y_fe_ad["alpha"]) ;
-    result["alpha"] = alpha ;
+    result["alpha"] = est.fe.alpha ;
   }
   if (force==2||force==3) {
-    xi = as<arma::mat>(Y_fe_ad["xi"]) ;
-    result["xi"] = xi ;
+    result["xi"] = est.fe.xi ;
   }
   return(result) ;
 }
 
 /* Obtain additive fe for ub data; assume r>0 but p=0*/
-// [[Rcpp::export]]
-List fe_ad_inter_iter (arma::mat Y,
-                       arma::mat I,
-                       int force,
-                       int mc, // whether pac or mc method
-                       int r,
-                       double lambda,
-                       double tolerate
-                       ) {
+IterFit fe_ad_inter_iter_core (const arma::mat& Y,
+                               const arma::mat& I,
+                               int force,
+                               int mc, // whether pac or mc method
+                               int r,
+                               double lambda,
+                               const IterControl& ctl,
+                               const arma::mat& factor0, // warm start, ignored if not T * r
+                               const FactorEngine& engine,
+                               const IterFit* warm // mc: previous fit on a lambda path, or NULL
+                               ) {
   int T = Y.n_rows ;
   int N = Y.n_cols ;
-  double mu = 0 ;
-  // double mu_old = 0 ;
   double dif = 1.0 ;
   int niter = 0 ;
   int validF = 1 ; // whether has a factor structure
 
   arma::mat VNT(r, r) ;
-  arma::mat FE_add_use(T, N, arma::fill::zeros) ;
-  arma::mat FE_inter_use(T, N, arma::fill::zeros) ;
-  arma::mat FE_inter_use_old(T, N, arma::fill::zeros) ;
-  arma::mat fit(T, N, arma::fill::zeros) ;
-  arma::mat U ;
-  
+  double mu = 0 ;
+  double mu_old = 0 ;
   arma::mat alpha(N, 1, arma::fill::zeros) ;
   arma::mat xi(T, 1, arma::fill::zeros) ;
-  double mu_Y = 0 ;
-  arma::mat alpha_Y(N, 1, arma::fill::zeros) ;
-  arma::mat xi_Y(T, 1, arma::fill::zeros) ;
+  arma::mat alpha_old(N, 1, arma::fill::zeros) ;
+  arma::mat xi_old(T, 1, arma::fill::zeros) ;
 
-  arma::mat F(T, r, arma::fill::zeros) ;
+  arma::mat F ; // empty: the first m-step starts cold
   arma::mat L(N, r, arma::fill::zeros) ;
-
-  //arma::mat F_old(T, r, arma::fill::zeros) ;
-  //arma::mat L_old(N, r, arma::fill::zeros) ;
-
-  arma::mat YY = Y ;
-
-  List Y_ad ;
-  List Y_fe_ad ;
-  List pf ;
-
-  while (dif > tolerate && niter <= 500) {
-    YY = E_adj(Y, fit, I) ; // e-step: expectation
-    // m1: estimate additive fe
-    Y_ad = Y_demean(YY - FE_inter_use, force) ;
-    mu_Y = as<double>(Y_ad["mu_Y"]) ;
-    if (force==1||force==3) {
-      alpha_Y = as<arma::mat>(Y_ad["alpha_Y"]) ;
+  if (factor0.n_rows == (arma::uword) T && factor0.n_cols == (arma::uword) r) {
+    F = factor0 ;
+  }
+  LowRank G ; // interactive fe: F * L' for pac, soft-thresholded for mc
+  LowRank G_old ;
+  if (mc == 1 && warm != NULL && warm->fe.alpha.n_rows == (arma::uword) N) {
+    mu = warm->fe.mu ;
+    alpha = warm->fe.alpha ;
+    xi = warm->fe.xi ;
+    G = warm->G ;
+  }
+
+  // the completed panel is Y at observed cells and the current fit
+  // mu + alpha + xi + G at missing cells. It is never formed: the
+  // additive step needs its row and column sums, the interactive
+  // step products with (completed panel - additive fe), which is the
+  // sparse observed residual plus a low-rank term, see below
+  CellIndex obs = cell_index(I, true) ;
+  CellIndex miss = cell_index(I, false) ;
+  arma::mat Y_obs = FE_adj(Y, I) ;
+  arma::mat rs_Y = sum(Y_obs, 1) ;
+  arma::mat cs_Y = sum(Y_obs, 0).t() ;
+  arma::mat rs(T, 1) ;
+  arma::mat cs(N, 1) ;
+  SpLowRank U ;
+  // the residual at the observed cells is stored at every one of them,
+  // zero or not, so the sparsity pattern is fixed and each step only
+  // rewrites the values, U_res, in the order of obs
+  U.S = arma::sp_mat(obs.loc, arma::zeros<arma::vec>(obs.loc.n_cols),
+                     T, N, false, false) ;
+  double* U_res = arma::access::rwp(U.S.values) ;
+  LowRank none ;
+  FactorWork fwork ;
+  DistWork dwork ; // for the step
+  DistWork nwork ; // for the norm of G
+  Squarem<FeLowRank> acc(ctl.accel) ; // on (mu, alpha, xi, G)
+  IterTrace iters ;
+  IterClock clock ;
+
+  while (dif > ctl.tol && niter < iter_budget(ctl, 501)) {
+    // m1: estimate additive fe of the completed panel net of G;
+    // at missing cells this is the additive fit itself
+    rs = rs_Y ;
+    cs = cs_Y ;
+    if (G.d.n_elem > 0) {
+      rs -= G.U * (G.d % sum(G.V, 0).t()) ; // gemv into rs
+      cs -= G.V * (G.d % sum(G.U, 0).t()) ;
+    }
+    for (int i = 0; i < N; i++) {
+      for (arma::uword k = miss.colptr(i); k < miss.colptr(i + 1); k++) {
+        arma::uword t = miss.loc(0, k) ;
+        double v = mu + alpha(i) + xi(t) + lowrank_at(G, t, i) ;
+        rs(t) += v ;
+        cs(i) += v ;
+      }
     }
-    if (force==2||force==3) {
-      xi_Y = as<arma::mat>(Y_ad["xi_Y"]) ;
+    for (int i = 0; i < N; i++) {
+      for (arma::uword k = obs.colptr(i); k < obs.colptr(i + 1); k++) {
+        arma::uword t = obs.loc(0, k) ;
+        U_res[k] = Y(t, i) - mu - alpha(i) - xi(t) - lowrank_at(G, t, i) ;
+      }
     }
-    Y_fe_ad = fe_add2(alpha_Y, xi_Y, mu_Y,
-                      T, N, force) ;
-    FE_add_use = as<arma::mat>(Y_fe_ad["FE_ad"]) ; // additive fe
-    
-    // m2: estimate interactive fe
-    U = YY - FE_add_use ;
+    mu_old = mu ;
+    alpha_old = alpha ;
+    xi_old = xi ;
+    fe_add_sums(rs, cs, force, mu, alpha, xi) ;
+
+    // m2: estimate interactive fe of completed panel - new additive fe
+    //     = observed residual + G + (old - new additive fe)
+    //     = U.S + U.A U.B', U.A = [G.U diag(G.d), 1, xi_old - xi +
+    //     mu_old - mu], U.B = [G.V, alpha_old - alpha, 1], written
+    //     column by column into the buffers
+    arma::uword q = G.d.n_elem ;
+    U.A.set_size(T, q + 2) ;
+    U.B.set_size(N, q + 2) ;
+    for (arma::uword j = 0; j < q; j++) {
+      U.A.col(j) = G.U.col(j) * G.d(j) ;
+      U.B.col(j) = G.V.col(j) ;
+    }
+    U.A.col(q).ones() ;
+    U.A.col(q + 1) = xi_old - xi + mu_old - mu ;
+    U.B.col(q) = alpha_old - alpha ;
+    U.B.col(q + 1).ones() ;
+    G_old = G ;
     if (mc == 0) {
-      pf = panel_factor(U, r)  ;
-      F = as<arma::mat>(pf["factor"]) ;
-      L = as<arma::mat>(pf["lambda"]) ;
-      VNT = as<arma::mat>(pf["VNT"]) ;
-      FE_inter_use = F * L.t() ; // interactive fe
+      factor_extract(U, r, engine, F, L, VNT, F, fwork) ;
+      G.U = F ;
+      G.d = arma::ones<arma::vec>(r) ;
+      G.V = L ;
     }
     else {
-      FE_inter_use = panel_FE(U, lambda) ;
+      svt_extract(U, lambda, engine.method, G) ;
     }
 
-    fit = FE_add_use + FE_inter_use ; // new overall fe
-
-    mu = as<double>(Y_fe_ad["mu"]) ;
-    //dif = abs(mu - mu_old) ;
-    //mu_old = mu ;
-    //if (T < N) {
-    //  dif = arma::norm(F - F_old, "fro")/(T*r) ;
-    //  F_old = F ;
-    //} else {
-    //  dif = arma::norm(L - L_old, "fro")/(N*r) ;
-    //  L_old = L ;
-    //}
-    dif = arma::norm(FE_inter_use - FE_inter_use_old, "fro")/(N*T) ;
-    FE_inter_use_old = FE_inter_use ;
+    double step = lowrank_dist(G, G_old, dwork) ;
+    dif = conv_measure(ctl, step/(N*T), step, lowrank_dist(G, none, nwork)) ;
 
     niter = niter + 1 ;
-  }
-  arma::mat e = YY - fit ;
-  e = FE_adj(e, I) ;
 
+    if (ctl.trace == 1) {
+      double seconds = clock.lap() ;
+      AddFE fe = {mu, alpha, xi} ;
+      trace_push(iters, obs_ssr(Y, fe_add_dense(fe, T, N)
+                                + lowrank_dense(G, T, N), miss),
+                 dif, seconds) ;
+      clock.reset() ;
+    }
+
+    if (acc.on == 1 && dif > ctl.tol) {
+      FeLowRank x ;
+      x.fe = arma::join_cols(arma::vec({mu}),
+                             arma::join_cols(arma::vectorise(alpha),
+                                             arma::vectorise(xi))) ;
+      x.G = G ;
+      if (acc.push(x)) {
+        mu = x.fe(0) ;
+        alpha = x.fe.subvec(1, N) ;
+        xi = x.fe.subvec(N + 1, N + T) ;
+        G = x.G ;
+      }
+    }
+  }
+  arma::mat FE_inter_use = lowrank_dense(G, T, N) ;
   if (arma::accu(abs(FE_inter_use)) < 1e-10) {
     validF = 0 ;
   }
 
+  IterFit est ;
+  est.fe.mu = mu ;
+  est.fe.alpha = alpha ;
+  est.fe.xi = xi ;
+  est.fit = fe_add_dense(est.fe, T, N) + FE_inter_use ;
+  est.e = Y - est.fit ;
+  zero_cells(est.e, miss) ;
+  est.niter = niter ;
+  est.saved = acc.saved ;
+  est.trace = iters ;
+  est.validF = validF ;
+  if (mc == 0) {
+    est.factor = F ;
+    est.lambda = L ;
+    est.VNT = VNT ;
+  }
+  else {
+    est.G = G ;
+  }
+  return(est) ;
+}
+
+// [[Rcpp::export]]
+List fe_ad_inter_iter (const arma::mat& Y,
+                       const arma::mat& I,
+                       int force,
+                       int mc, // whether pac or mc method
+                       int r,
+                       double lambda,
+                       double tolerate,
+                       const arma::mat& factor0, // warm start, ignored if not T * r
+                       int svd_method = 0,
+                       int oversample = 10,
+                       int power = 2,
+                       int accel = 0,
+                       Rcpp::Nullable<Rcpp::List> control = R_NilValue // see iter_control
+                       ) {
+  FactorEngine engine = {svd_method, oversample, power} ;
+  IterControl ctl = iter_control(tolerate, control) ;
+  ctl.accel = accel ;
+  IterFit est = fe_ad_inter_iter_core(Y, I, force, mc, r, lambda, ctl,
+                                      factor0, engine) ;
   List result;
-  result["mu"] = mu ;
-  result["niter"] = niter ;
-  result["fit"] = fit ;
-  result["e"] = e ;
-  result["validF"] = validF ;
+  result["mu"] = est.fe.mu ;
+  result["niter"] = est.niter ;
+  if (accel == 1) {
+    result["niter.saved"] = est.saved ;
+  }
+  result["fit"] = est.fit ;
+  result["e"] = est.e ;
+  result["validF"] = est.validF ;
   if (force==1||force==3) {
-    alpha = as<arma::mat>(Y_fe_ad["alpha"]) ;
-    result["alpha"] = alpha ;
+    result["alpha"] = est.fe.alpha ;
   }
   if (force==2||force==3) {
-    xi = as<arma::mat>(Y_fe_ad["xi"]) ;
-    result["xi"] = xi ;
+    result["xi"] = est.fe.xi ;
   }
   if (mc == 0) {
-    result["lambda"] = L ;
-    result["factor"] = F ;
-    result["VNT"] = VNT ;
+    result["lambda"] = est.lambda ;
+    result["factor"] = est.factor ;
+    result["VNT"] = est.VNT ;
   }
   return(result) ;
 }
 
 /* Obtain additive fe for ub data; assume r>0 p>0*/
-// [[Rcpp::export]]
-List fe_ad_inter_covar_iter (arma::cube XX,
-                             arma::mat xxinv,
-                             arma::mat alpha_X,
-                             arma::mat xi_X,
-                             arma::mat mu_X,
-                             arma::mat Y,
-                             arma::mat I,
-                             int force,
-                             int mc, // whether pac or mc method
-                             int r,
-                             double lambda,
-                             double tolerate
-                             ) {
+IterFit fe_ad_inter_covar_iter_core (const arma::cube& XX,
+                                     const GramSolver& gram,
+                                     const arma::mat& alpha_X,
+                                     const arma::mat& xi_X,
+                                     const arma::mat& mu_X,
+                                     const arma::mat& Y,
+                                     const arma::mat& I,
+                                     int force,
+                                     int mc, // whether pac or mc method
+                                     int r,
+                                     double lambda,
+                                     const IterControl& ctl,
+                                     const arma::mat& factor0, // warm start, ignored if not T * r
+                                     const FactorEngine& engine,
+                                     const IterFit* warm // mc: previous fit on a lambda path, or NULL
+                                     ) {
   int T = Y.n_rows ;
   int N = Y.n_cols ;
   int p = XX.n_slices ;
@@ -751,11 +2190,9 @@ List fe_ad_inter_covar_iter (arma::cube XX,
   arma::mat FE_inter_use(T, N, arma::fill::zeros) ;
   arma::mat covar_fit(T, N, arma::fill::zeros) ;
   arma::mat fit(T, N, arma::fill::zeros) ;
-  arma::mat U ;
+  arma::mat U(T, N) ;
+  arma::mat R(T, N) ; // YY_demean - FE_inter_use
 
-  arma::mat FE_ad(T, N, arma::fill::zeros) ;
-  arma::mat alpha(N, 1, arma::fill::zeros) ;
-  arma::mat xi(T, 1, arma::fill::zeros) ;
   double mu_Y = 0 ;
   arma::mat alpha_Y(N, 1, arma::fill::zeros) ;
   arma::mat xi_Y(T, 1, arma::fill::zeros) ;
@@ -764,108 +2201,170 @@ List fe_ad_inter_covar_iter (arma::cube XX,
 
   arma::mat YY = Y ;
 
-  List pf ;
-  List Y_fe_ad ;
-  List Y_ad ; 
-
   arma::mat F ;
   arma::mat L ;
-
-  while (dif > tolerate && niter <= 500) {
-    YY =  E_adj (Y, fit, I) ; // e-step: expectation
+  LowRank Z ; // mc: soft-thresholded fit
+  LowRank Z_old ;
+  if (factor0.n_rows == (arma::uword) T && factor0.n_cols == (arma::uword) r) {
+    F = factor0 ;
+  }
+  if (mc == 1 && warm != NULL && warm->fit.n_cols == (arma::uword) N
+      && warm->beta.n_rows == (arma::uword) p) {
+    beta = warm->beta ;
+    beta_old = beta ;
+    Z = warm->G ;
+    FE_inter_use = lowrank_dense(Z, T, N) ;
+    fit = warm->fit ;
+  }
+  CellIndex miss = cell_index(I, false) ;
+  // the next step depends on the interactive fe and the fit at
+  // missing cells; the accelerator works on both, stacked
+  Squarem<arma::vec> acc(ctl.accel) ;
+  FactorWork fwork ;
+  IterTrace iters ;
+  IterClock clock ;
+
+  while (dif > ctl.tol && niter < iter_budget(ctl, 501)) {
+    fill_cells(YY, fit, miss) ; // e-step: expectation
     
     // m1: estimate beta and add fe
-    Y_ad = Y_demean(YY, force) ;
-    YY_demean = as<arma::mat>(Y_ad["YY"]) ;
-    beta = panel_beta(XX, xxinv, YY_demean, FE_inter_use) ;
+    YY_demean = YY ;
+    demean_into(YY_demean, mu_Y, alpha_Y, xi_Y, force) ;
+    R = YY_demean - FE_inter_use ;
+    panel_beta_into(beta, XX, gram, R) ;
 
-    mu_Y = as<double>(Y_ad["mu_Y"]) ;
-    if (force==1||force==3) {
-      alpha_Y = as<arma::mat>(Y_ad["alpha_Y"]) ;
-    }
-    if (force==2||force==3) {
-      xi_Y = as<arma::mat>(Y_ad["xi_Y"]) ;
-    }
-    Y_fe_ad = fe_add(alpha_X, xi_X, mu_X, alpha_Y, xi_Y, mu_Y, 
-                          beta, T, N, p, force) ;
-    covar_fit.zeros() ;
-    for (int i = 0; i < p; i++) {
-      covar_fit = covar_fit + XX.slice(i) * beta(i) ;
-    }
-    if (force == 0) {
-      covar_fit = covar_fit + mu_Y ;
-    }
-    if (force == 1) {
-      covar_fit = covar_fit + repmat(alpha_Y.t(), T, 1) ;
-    }
-    if (force == 2) {
-      covar_fit = covar_fit + repmat(xi_Y, 1, N) ;
-    }
-    if (force == 3) {
-      covar_fit = covar_fit + repmat(alpha_Y.t(), T, 1) + repmat(xi_Y, 1, N) - mu_Y ;
-    }
+    covar_fit_into(covar_fit, XX, beta) ;
+    remean_into(covar_fit, mu_Y, alpha_Y, xi_Y, force) ;
     
     // m2: estimate interactive fe
     U = YY - covar_fit ;
 
     if (mc == 0) {
-      pf = panel_factor(U, r)  ;
-      F = as<arma::mat>(pf["factor"]) ;
-      L = as<arma::mat>(pf["lambda"]) ;
-      VNT = as<arma::mat>(pf["VNT"]) ;
+      factor_extract(U, r, engine, F, L, VNT, F, fwork) ;
       FE_inter_use = F * L.t() ; // interactive fe
     }
     else {
-      FE_inter_use = panel_FE(U, lambda) ;
+      Z_old = Z ;
+      svt_extract(U, lambda, engine.method, Z) ;
+      FE_inter_use = lowrank_dense(Z, T, N) ;
     }
 
     fit = covar_fit + FE_inter_use ; // overall fe 
 
-    dif = arma::norm(beta - beta_old, "fro")/p ;
+    double step = arma::norm(beta - beta_old, "fro") ;
+    dif = conv_measure(ctl, step/p, step, arma::norm(beta, "fro")) ;
+    if (warm != NULL && mc == 1) {
+      // beta starts converged on a path, wait for the low-rank part too
+      double step_Z = lowrank_dist(Z, Z_old) ;
+      dif = std::max(dif, conv_measure(ctl, step_Z/(N*T), step_Z,
+                                       sqrt(lowrank_dot(Z, Z)))) ;
+    }
     beta_old = beta ;
 
     niter = niter + 1 ;
-  }
-  arma::mat e = YY - fit ;
-  e = FE_adj(e, I) ;
 
+    if (ctl.trace == 1) {
+      double seconds = clock.lap() ;
+      trace_push(iters, obs_ssr(YY, fit, miss), dif, seconds) ;
+      clock.reset() ;
+    }
+
+    if (acc.on == 1 && dif > ctl.tol) {
+      arma::vec x = arma::join_cols(arma::vectorise(FE_inter_use),
+                                    cells_of(fit, miss)) ;
+      if (acc.push(x)) {
+        FE_inter_use = arma::reshape(x.head(T * N), T, N) ;
+        set_cells(fit, x.tail(x.n_elem - T * N), miss) ;
+      }
+    }
+  }
   if (arma::accu(abs(FE_inter_use)) < 1e-10) {
     validF = 0 ;
   }
 
+  IterFit est ;
+  est.fe = fe_add_core(alpha_X, xi_X, mu_X, alpha_Y, xi_Y, mu_Y, 
+                       beta, T, N, force) ;
+  est.beta = beta ;
+  est.e = YY - fit ;
+  zero_cells(est.e, miss) ;
+  est.fit = fit ;
+  est.niter = niter ;
+  est.saved = acc.saved ;
+  est.trace = iters ;
+  est.validF = validF ;
+  if (mc == 0) {
+    est.factor = F ;
+    est.lambda = L ;
+    est.VNT = VNT ;
+  }
+  else {
+    est.G = Z ;
+  }
+  return(est) ;
+}
+
+// [[Rcpp::export]]
+List fe_ad_inter_covar_iter (const arma::cube& XX,
+                             const arma::mat& xxinv,
+                             const arma::mat& alpha_X,
+                             const arma::mat& xi_X,
+                             const arma::mat& mu_X,
+                             const arma::mat& Y,
+                             const arma::mat& I,
+                             int force,
+                             int mc, // whether pac or mc method
+                             int r,
+                             double lambda,
+                             double tolerate,
+                             const arma::mat& factor0, // warm start, ignored if not T * r
+                             int svd_method = 0,
+                             int oversample = 10,
+                             int power = 2,
+                             int accel = 0
+                             ) {
+  FactorEngine engine = {svd_method, oversample, power} ;
+  IterControl ctl = iter_control(tolerate) ;
+  ctl.accel = accel ;
+  IterFit est = fe_ad_inter_covar_iter_core(XX, gram_inverse(xxinv),
+                                            alpha_X, xi_X, mu_X,
+                                            Y, I, force, mc, r, lambda,
+                                            ctl, factor0, engine) ;
   List result;
-  result["mu"] = as<double>(Y_fe_ad["mu"]) ;
-  result["niter"] = niter ;
-  result["e"] = e ;
-  result["beta"] = beta ;
-  result["fit"] = fit ;
-  result["validF"] = validF ;
+  result["mu"] = est.fe.mu ;
+  result["niter"] = est.niter ;
+  if (accel == 1) {
+    result["niter.saved"] = est.saved ;
+  }
+  result["e"] = est.e ;
+  result["beta"] = est.beta ;
+  result["fit"] = est.fit ;
+  result["validF"] = est.validF ;
 
   if (force==1||force==3) {
-    alpha = as<arma::mat>(Y_fe_ad["alpha"]) ;
-    result["alpha"] = alpha ;
+    result["alpha"] = est.fe.alpha ;
   }
   if (force==2||force==3) {
-    xi = as<arma::mat>(Y_fe_ad["xi"]) ;
-    result["xi"] = xi ;
+    result["xi"] = est.fe.xi ;
   }
 
   if (mc == 0) {
-    result["lambda"] = L ;
-    result["factor"] = F ;
-    result["VNT"] = VNT ;
+    result["lambda"] = est.lambda ;
+    result["factor"] = est.factor ;
+    result["VNT"] = est.VNT ;
   }
   return(result) ;
 }
 
 /* Main iteration for beta */
-// [[Rcpp::export]]
-List beta_iter (arma::cube X,
-                arma::mat xxinv,
-                arma::mat Y,
-                int r,
-                double tolerate,
-                arma::mat beta0) {
+IterFit beta_iter_core (const arma::cube& X,
+                        const GramSolver& gram,
+                        const arma::mat& Y,
+                        int r,
+                        const IterControl& ctl,
+                        const arma::mat& beta0,
+                        const arma::mat& factor0,
+                        const FactorEngine& engine) {
 
   /* beta.new: computed beta under iteration with error precision=tolerate
      factor: estimated factor
@@ -885,56 +2384,105 @@ List beta_iter (arma::cube X,
   arma::mat beta_old = beta ;
   arma::mat VNT(r, r, arma::fill::zeros) ;
   arma::mat FE(T, N, arma::fill::zeros) ;
+  arma::mat R(T, N) ; // Y - FE
+  arma::mat U(T, N) ;
 
   /* starting value */
-  arma::mat U = Y ;
-  for (int k = 0; k < p; k++) {
-    U = U - X.slice(k) * beta(k) ;
-  }
-  List pf = panel_factor(U, r)  ;
-  arma::mat F = as<arma::mat>(pf["factor"]) ;
-  arma::mat L = as<arma::mat>(pf["lambda"]) ;
+  arma::mat F ;
+  arma::mat L ;
+  FactorWork fwork ;
+  covar_resid_into(U, Y, X, beta) ;
+  factor_extract(U, r, engine, F, L, VNT, factor0, fwork) ;
  
-  /* Loop */
+  /* Loop: each step is seeded with the factors of the previous one */
   int niter = 0 ;
-  while ((beta_norm > tolerate) && (niter < 500)) {
+  Squarem<arma::vec> acc(ctl.accel) ; // on beta
+  IterTrace iters ;
+  IterClock clock ;
+  while ((beta_norm > ctl.tol) && (niter < iter_budget(ctl, 500))) {
     niter++ ; 
     FE = F * L.t() ;
-    beta = panel_beta(X, xxinv, Y, FE) ;
-    beta_norm = arma::norm(beta - beta_old, "fro") ; 
+    R = Y - FE ;
+    panel_beta_into(beta, X, gram, R) ;
+    double step = arma::norm(beta - beta_old, "fro") ; 
+    beta_norm = conv_measure(ctl, step, step, arma::norm(beta, "fro")) ;
+    if (acc.on == 1 && beta_norm > ctl.tol) {
+      arma::vec x = arma::vectorise(beta) ;
+      if (acc.push(x)) {
+        beta = x ;
+      }
+    }
     beta_old = beta ;
-    U = Y ;
-    for (int k = 0; k < p; k++) {
-      U = U - X.slice(k) * beta(k) ;
+    covar_resid_into(U, Y, X, beta) ;
+    factor_extract(U, r, engine, F, L, VNT, F, fwork) ;
+    if (ctl.trace == 1) {
+      double seconds = clock.lap() ;
+      trace_push(iters, arma::accu(arma::square(U - F * L.t())), beta_norm,
+                 seconds) ;
+      clock.reset() ;
     }
-    pf = panel_factor(U, r)  ;
-    F = as<arma::mat>(pf["factor"]) ;
-    L = as<arma::mat>(pf["lambda"]) ; 
   }
-  VNT = as<arma::mat>(pf["VNT"]) ; 
-  arma::mat e = U - F * L.t() ;
 
   /* Storage */
+  IterFit est ;
+  est.niter = niter ;
+  est.saved = acc.saved ;
+  est.trace = iters ;
+  est.beta = beta ;
+  est.e = U - F * L.t() ;
+  est.factor = F ;
+  est.lambda = L ;
+  est.VNT = VNT ;
+  return(est)  ;
+}
+
+// [[Rcpp::export]]
+List beta_iter (const arma::cube& X,
+                const arma::mat& xxinv,
+                const arma::mat& Y,
+                int r,
+                double tolerate,
+                const arma::mat& beta0,
+                const arma::mat& factor0,
+                int svd_method = 0,
+                int oversample = 10,
+                int power = 2,
+                int accel = 0,
+                Rcpp::Nullable<Rcpp::List> control = R_NilValue // see iter_control
+                ) {
+  FactorEngine engine = {svd_method, oversample, power} ;
+  IterControl ctl = iter_control(tolerate, control) ;
+  ctl.accel = accel ;
+  IterFit est = beta_iter_core(X, gram_inverse(xxinv), Y, r, ctl,
+                               beta0, factor0, engine) ;
   List result ;
-  result["niter"] = niter ;
-  result["beta"] = beta ;
-  result["e"] = e ; 
-  result["lambda"] = L ;
-  result["factor"] = F ;
-  result["VNT"] = VNT ;
+  result["niter"] = est.niter ;
+  if (accel == 1) {
+    result["niter.saved"] = est.saved ;
+  }
+  result["beta"] = est.beta ;
+  result["e"] = est.e ; 
+  result["lambda"] = est.lambda ;
+  result["factor"] = est.factor ;
+  result["VNT"] = est.VNT ;
   return(result)  ;
 }
 
 /* Main iteration for beta: unbalanced without additive fixed effects,
    useless under the assumption of non-zero grandmean */
 // [[Rcpp::export]]
-List beta_iter_ub (arma::cube X,
-                   arma::mat xxinv,
-                   arma::mat Y,
-                   arma::mat I,
+List beta_iter_ub (const arma::cube& X,
+                   const arma::mat& xxinv,
+                   const arma::mat& Y,
+                   const arma::mat& I,
                    int r,
                    double tolerate,
-                   arma::mat beta0) { 
+                   const arma::mat& beta0,
+                   int svd_method = 0,
+                   int oversample = 10,
+                   int power = 2) { 
+  FactorEngine engine = {svd_method, oversample, power} ;
+  GramSolver gram = gram_inverse(xxinv) ;
   int T = Y.n_rows ;
   int N = Y.n_cols ;
   int p = X.n_slices ;
@@ -948,17 +2496,16 @@ List beta_iter_ub (arma::cube X,
   arma::mat beta_old = beta ;  
   arma::mat VNT(r, r, arma::fill::zeros) ;
   arma::mat FE(T, N, arma::fill::zeros) ;
-  arma::mat FE_use(T, N, arma::fill::zeros) ; // intermediate value
-  arma::mat U_use(T, N, arma::fill::zeros) ; // intermediate value
+  arma::mat R(T, N) ; // Y - FE_use, intermediate value
+  arma::mat U(T, N) ;
+  CellIndex miss = cell_index(I, false) ;
 
   /* starting value */
-  arma::mat U = Y ;
-  for (int k = 0; k < p; k++) {
-    U = U - X.slice(k) * beta(k) ;
-  }
-  List pf = panel_factor(U, r)  ;
-  arma::mat F = as<arma::mat>(pf["factor"]) ;
-  arma::mat L = as<arma::mat>(pf["lambda"]) ;
+  arma::mat F ;
+  arma::mat L ;
+  FactorWork fwork ;
+  covar_resid_into(U, Y, X, beta) ;
+  factor_extract(U, r, engine, F, L, VNT, arma::mat(), fwork) ;
  
   /* Loop */
   int niter = 0 ;
@@ -967,25 +2514,22 @@ List beta_iter_ub (arma::cube X,
     FE = F * L.t() ;
     /* estimate beta */
     // set missing value = 0
-    FE_use = FE_adj(FE = FE, I = I) ;
-    beta = panel_beta(X, xxinv, Y, FE_use) ;
+    R = Y - FE ;
+    fill_cells(R, Y, miss) ;
+    panel_beta_into(beta, X, gram, R) ;
     beta_norm = arma::norm(beta - beta_old, "fro")/p ; 
     beta_old = beta ;
-    U = Y ;
-    for (int k = 0; k < p; k++) {
-      U = U - X.slice(k) * beta(k) ;
-    }
     /* estimate interactive fe */
     // Expectation for missing value
-    U_use = E_adj(U, FE, I) ;
-    pf = panel_factor(U_use, r)  ;
-    F = as<arma::mat>(pf["factor"]) ;
-    L = as<arma::mat>(pf["lambda"]) ; 
+    covar_resid_into(U, Y, X, beta) ;
+    fill_cells(U, FE, miss) ;
+    factor_extract(U, r, engine, F, L, VNT, F, fwork) ;
   }
-  VNT = as<arma::mat>(pf["VNT"]) ; 
+  // U holds FE at the missing cells: restore the residual there
+  covar_resid_into(U, Y, X, beta) ;
   FE = F * L.t() ;
-  FE_use = FE_adj(FE = FE, I = I) ;
-  arma::mat e = U - FE_use ;
+  zero_cells(FE, miss) ;
+  arma::mat e = U - FE ;
 
   /* Storage */
   List result ;
@@ -998,78 +2542,45 @@ List beta_iter_ub (arma::cube X,
   return(result)  ;
 }
 
-/* Interactive Fixed Effects */
-// [[Rcpp::export]]
-List inter_fe (arma::mat Y,
-               arma::cube X,
-               int r,
-               int force,
-               arma::mat beta0, 
-               double tol = 1e-5
-               ) { 
+/* Interactive Fixed Effects: demean the outcome of a prepared panel;
+   y.YY holds the raw outcome on entry. The covariates are left
+   alone, so em steps that only change the outcome call this alone */
+void inter_fe_prep_y (OutcomePrep& y, int force) {
+  arma::mat& YY = y.YY ;
+  int T = YY.n_rows ;
+  int N = YY.n_cols ;
+
+  /* grand mean, unit and time fixed effects; the latter two are
+     deviations from the grand mean */
+  y.alpha_Y.set_size(N, 1) ;
+  y.xi_Y.set_size(T, 1) ;
+  twoway_demean(YY.memptr(), T, N, force, 1, y.mu_Y,
+                y.alpha_Y.memptr(), y.xi_Y.memptr()) ;
+}
+
+/* Interactive Fixed Effects: data preparation, shared by all r */
+void inter_fe_prep (PanelPrep& prep,
+                    const arma::mat& Y,
+                    const arma::cube& X,
+                    int force,
+                    const arma::uvec& units // columns to use, empty for all
+                    ) {
   /* Dimensions */
-  int b_r = beta0.n_rows ; 
-  int T = Y.n_rows ;
-  int N = Y.n_cols ;
-  int p = X.n_slices ;
-  int obs = T * N ;
-  int niter = 0 ;
-  arma::mat factor ;
-  arma::mat lambda ;
-  arma::mat VNT ;
-  arma::mat beta ; 
-  arma::mat U ;
-  double mu = 0 ;
-  double mu_Y = 0 ;
+  int T = Y.n_rows ;
+  int N = units.n_elem > 0 ? units.n_elem : Y.n_cols ;
+  int p = X.n_slices ;
   arma::mat mu_X(p, 1) ;
-  arma::mat alpha(N, 1, arma::fill::zeros) ;
-  arma::mat alpha_Y(N, 1) ;
   arma::mat alpha_X(N, p) ;
-  arma::mat xi(T, 1, arma::fill::zeros) ;
-  arma::mat xi_Y(T, 1) ;
   arma::mat xi_X(T, p) ;
-  double sigma2 ;
-  double IC ;
-  //arma::mat FE(T, N, arma::fill::zeros) ;
-  arma::mat invXX ;
+  GramSolver gram ; // factorization of X'X
 
   /* duplicate data */
-  arma::mat YY = Y;
-  arma::cube XX = X;
+  arma::cube XX ;
+  panel_gather(prep.y.YY, XX, Y, X, units) ;
+  inter_fe_prep_y(prep.y, force) ;
    
-  /* grand mean */
-  mu_Y  =  accu(YY)/obs ;
-  YY  =  YY - mu_Y ;
-  if (p > 0) {
-    for (int i = 0; i < p; i++) {
-      mu_X(i,0)  =  accu(XX.slice(i))/obs ;
-      XX.slice(i) =  XX.slice(i)- mu_X(i,0) ;
-    }
-  }
-  
-  /* unit fixed effects */
-  if (force ==1 || force ==3 ) {
-    alpha_Y  =  mean(YY, 0).t() ; // colMeans, (N * 1) matrix
-    YY  =  YY - repmat(alpha_Y.t(), T, 1) ; // (T * N) matrix 
-    if (p > 0) {
-      for (int i = 0; i < p; i++) {
-        alpha_X.col(i)  = mean(XX.slice(i), 0).t(); // colMeans 
-        XX.slice(i) = XX.slice(i) - repmat(alpha_X.col(i).t(), T, 1) ;
-      }
-    } 
-  }
-  
-  /* time fixed effects  */
-  if ( force == 2 || force == 3 ) {
-    xi_Y  =  mean(YY, 1); //rowMeans, (N * 1) matrix
-    YY  =  YY - repmat(xi_Y, 1, N);
-    if (p > 0) {
-      for (int i = 0; i < p; i++) {
-        xi_X.col(i)  =  mean(XX.slice(i), 1) ; //rowMeans
-        XX.slice(i) =  XX.slice(i) - repmat(xi_X.col(i), 1, N) ;
-      }
-    }  
-  }
+  /* grand mean, unit and time fixed effects of every covariate */
+  twoway_demean_cube(XX, force, 1, mu_X, alpha_X, xi_X) ;
 
   /* check if XX has enough variation */
   int p1=p; 
@@ -1089,21 +2600,81 @@ List inter_fe (arma::mat Y,
     j++;
   }
 
+  /* ... and no covariate is collinear with the others */
+  p1 = shed_collinear(XX, mu_X, alpha_X, xi_X, X_invar, gram) ;
+
   int validX = 1;
   if(p1==0){
     validX = 0;
   }
-  else {
-    invXX =  XXinv(XX) ;
-  }
- 
+
+  prep.x.XX = std::move(XX) ;
+  prep.x.mu_X = mu_X ;
+  prep.x.alpha_X = alpha_X ;
+  prep.x.xi_X = xi_X ;
+  prep.x.X_invar = X_invar ;
+  prep.x.gram = gram ;
+  prep.x.p1 = p1 ;
+  prep.x.validX = validX ;
+}
+
+/* Interactive Fixed Effects: fit with r factors on a prepared panel,
+   covariate side x and outcome side y */
+InterFit inter_fe_solve (const CovarPrep& x,
+                         const OutcomePrep& y,
+                         int r,
+                         int force,
+                         arma::mat beta0,
+                         const IterControl& ctl,
+                         const FactorEngine& engine,
+                         const arma::mat& factor0 // warm start, may be empty
+                         ) {
+  const arma::mat& YY = y.YY ;
+  const arma::cube& XX = x.XX ;
+  const arma::mat& X_invar = x.X_invar ;
+  const GramSolver& gram = x.gram ;
+  double mu_Y = y.mu_Y ;
+  const arma::mat& alpha_Y = y.alpha_Y ;
+  const arma::mat& xi_Y = y.xi_Y ;
+  const arma::mat& mu_X = x.mu_X ;
+  const arma::mat& alpha_X = x.alpha_X ;
+  const arma::mat& xi_X = x.xi_X ;
+  int p1 = x.p1 ;
+  int validX = x.validX ;
+
+  /* Dimensions */
+  int b_r = beta0.n_rows ; 
+  int T = YY.n_rows ;
+  int N = YY.n_cols ;
+  int p = X_invar.n_rows ;
+  int niter = 0 ;
+  IterTrace iters ;
+  double saved = 0 ;
+  arma::mat factor ;
+  arma::mat lambda ;
+  arma::mat VNT ;
+  arma::mat beta ; 
+  arma::mat U ;
+  double mu = 0 ;
+  arma::mat alpha(N, 1, arma::fill::zeros) ;
+  arma::mat xi(T, 1, arma::fill::zeros) ;
+  double sigma2 ;
+  double IC ;
+
+  const arma::mat& F0 = factor0 ; // warm start, e.g. from a previous em step
+
   /* Main Algorithm */ 
   if (p1 == 0) {
     if (r > 0) {
-      List pf = panel_factor(YY, r)  ;
-      factor = as<arma::mat>(pf["factor"]) ;
-      lambda = as<arma::mat>(pf["lambda"]) ;
-      VNT = as<arma::mat>(pf["VNT"]) ;
+      if (y.factor.n_cols >= (arma::uword) r) {
+        // nested: the leading factors of a larger decomposition of YY
+        factor = y.factor.head_cols(r) ;
+        lambda = y.lambda.head_cols(r) ;
+        VNT = diagmat(y.eig.head(r)) ;
+      }
+      else {
+        factor_extract(YY, r, engine, factor, lambda, VNT, F0) ;
+      }
       U  =  YY - factor * lambda.t() ;
     } 
     else {
@@ -1113,24 +2684,23 @@ List inter_fe (arma::mat Y,
   else {
     /* starting value:  the OLS/LSDV estimator */
     if (accu(abs(beta0))< 1e-10 || r==0 || b_r != p1 ) {  //
-      beta0 = panel_beta(XX, invXX, YY, arma::zeros<arma::mat>(T,N)); //
+      panel_beta_into(beta0, XX, gram, YY) ; //
     }
     if (r==0) {
-      U = YY;
       beta  =  beta0 ;
-      for (int k = 0; k < p1; k++) {
-        U =  U - XX.slice(k) * beta(k,0);
-      }
+      covar_resid_into(U, YY, XX, beta) ;
     } 
     else if (r > 0) {  
-      // arma::mat invXX =  XXinv(XX) ;  // compute (X'X)^{-1}, outside beta iteration      
-      List out  =  beta_iter(XX, invXX, YY, r, tol, beta0) ;
-      beta  = as<arma::mat>(out["beta"]) ;
-      factor  =  as<arma::mat>(out["factor"]) ;
-      lambda  =  as<arma::mat>(out["lambda"]) ;
-      VNT  =  as<arma::mat>(out["VNT"]) ;
-      U  =  as<arma::mat>(out["e"]);
-      niter = as<int>(out["niter"]) ;
+      IterFit out  =  beta_iter_core(XX, gram, YY, r, ctl, beta0, F0,
+                                     engine) ;
+      beta  = out.beta ;
+      factor  =  out.factor ;
+      lambda  =  out.lambda ;
+      VNT  =  out.VNT ;
+      U  =  out.e ;
+      niter = out.niter ;
+      iters = out.trace ;
+      saved = out.saved ;
     }
   } 
     
@@ -1166,143 +2736,155 @@ List inter_fe (arma::mat Y,
   // Storage
   //-------------------------------# 
 
-  List output ;
-  
-  output["mu"] = mu ;
-  // output["p1"] = p1 ; 
+  InterFit out ;
+  out.mu = mu ;
+  out.p1 = p1 ;
  
   if(p>0) {
-    // output["beta_valid"] = beta ;
     arma::mat beta_total(p,1);
-    // arma::mat beta_tot(p,1);
 
     if(p>p1) {
       int j4= 0;
       for(int i=0; i<p; i++) {
         if(X_invar(i,0)==1) {
           beta_total(i,0) = arma::datum::nan;
-          // beta_tot(i,0) = 0;
         }
         else {
           beta_total(i,0) = beta(j4,0);
-          // beta_tot(i,0) = beta(j4,0);
           j4++;
         }
       }
     }
     else {
       beta_total = beta;
-      // beta_tot = beta;
     }
-    output["beta"] = beta_total;
-    // output["beta_tot"] = beta_tot;
+    out.beta = beta_total;
   }  
 
+  out.factor = factor ;
+  out.lambda = lambda ;
+  out.VNT = VNT ;
+  out.niter = niter ;
+  out.trace = iters ;
+  out.saved = saved ;
+  out.alpha = alpha ;
+  out.xi = xi ;
+  out.residuals = U ;
+  out.sigma2 = sigma2 ;
+  out.IC = IC ;
+  out.validX = validX ;
+  return(out);
+}
+
+/* Interactive Fixed Effects */
+InterFit inter_fe_core (const arma::mat& Y,
+                        const arma::cube& X,
+                        int r,
+                        int force,
+                        const arma::mat& beta0,
+                        const IterControl& ctl,
+                        const FactorEngine& engine,
+                        const arma::mat& factor0, // warm start, may be empty
+                        const arma::uvec& units // columns to use, empty for all
+                        ) { 
+  PanelPrep prep ;
+  inter_fe_prep(prep, Y, X, force, units) ;
+  return(inter_fe_solve(prep.x, prep.y, r, force, beta0, ctl, engine,
+                        factor0)) ;
+}
+
+/* the List returned by inter_fe */
+List inter_fe_output (const InterFit& est, int p, int r, int force) {
+  List output ;
+  
+  output["mu"] = est.mu ;
+  if (p > 0) {
+    output["beta"] = est.beta ;
+  }
   if (r > 0) {
-    output["factor"] = factor ;
-    output["lambda"] = lambda ;
-    output["VNT"] = VNT ;
-    //FE = factor * lambda.t() ;
-    //output["FE"] = FE ;
+    output["factor"] = est.factor ;
+    output["lambda"] = est.lambda ;
+    output["VNT"] = est.VNT ;
   }
-  if ((p1 > 0) && (r > 0)) {
-    output["niter"] = niter ;
+  if ((est.p1 > 0) && (r > 0)) {
+    output["niter"] = est.niter ;
+    output["niter.saved"] = est.saved ;
   }
   if (force ==1 || force == 3) {
-    output["alpha"] = alpha ;
+    output["alpha"] = est.alpha ;
   }
   if (force ==2 || force == 3) {
-    output["xi"] = xi ;
+    output["xi"] = est.xi ;
+  }
+  output["residuals"] = est.residuals ;
+  output["sigma2"] = est.sigma2 ;
+  output["IC"] = est.IC ;
+  output["validX"] = est.validX ;
+  if (est.trace.step.size() > 0) {
+    output["trace"] = trace_output(est.trace) ;
   }
-  output["residuals"] = U ;
-  output["sigma2"] = sigma2 ;
-  output["IC"] = IC ;
-  output["validX"] = validX ;
   return(output);
 }
 
-/* Interactive Fixed Effects: ub */
 // [[Rcpp::export]]
-List inter_fe_ub (arma::mat Y,
-                  arma::cube X,
-                  arma::mat I,
-                  int r, // r > 0, the outcome has a factor-type fixed effect; r = 0 else
-                  int force,
-                  double tol = 1e-5
-                  ) {
+List inter_fe (const arma::mat& Y,
+               const arma::cube& X,
+               int r,
+               int force,
+               const arma::mat& beta0,
+               double tol = 1e-5,
+               int svd_method = 0, // factor engine, see panel_factor
+               int oversample = 10,
+               int power = 2,
+               int precision = 0, // 1: factor extraction in single precision
+               Rcpp::Nullable<Rcpp::NumericMatrix> factor0 = R_NilValue, // warm start
+               Rcpp::Nullable<Rcpp::List> control = R_NilValue // see iter_control
+               ) { 
+  FactorEngine engine = {svd_method, oversample, power, precision} ;
+  IterControl ctl = iter_control(tol, control) ;
+  arma::mat F0 ;
+  if (factor0.isNotNull()) {
+    F0 = as<arma::mat>(factor0.get()) ;
+  }
+  InterFit est = inter_fe_core(Y, X, r, force, beta0, ctl, engine, F0,
+                               arma::uvec()) ;
+  return(inter_fe_output(est, X.n_slices, r, force)) ;
+}
+
+/* Interactive Fixed Effects: ub, data preparation shared by all r */
+void inter_fe_ub_prep (PanelPrep& prep,
+                       const arma::mat& Y,
+                       const arma::cube& X,
+                       const arma::mat& I_data,
+                       int force,
+                       const arma::uvec& units // columns to use, empty for all
+                       ) {
   
+  /* resampled indicator; the iterations index it densely */
+  if (units.n_elem > 0) {
+    prep.x.I = I_data.cols(units) ;
+  } else {
+    prep.x.I = I_data ;
+  }
+
   /* Dimensions */
   int T = Y.n_rows ;
-  int N = Y.n_cols ;
+  int N = prep.x.I.n_cols ;
   int p = X.n_slices ;
-  double obs = accu(I) ;
-  int niter = 0 ;
-  arma::mat factor ;
-  arma::mat lambda ;
-  arma::mat VNT ;
-  arma::mat beta ; 
-  arma::mat U ;
-  double mu_Y = 0 ;
-  double mu = 0 ;
   arma::mat mu_X(p, 1, arma::fill::zeros) ;
-  arma::mat alpha(N, 1, arma::fill::zeros) ;
-  arma::mat alpha_Y(N, 1, arma::fill::zeros) ;
   arma::mat alpha_X(N, p, arma::fill::zeros) ;
-  arma::mat xi(T, 1, arma::fill::zeros) ;
-  arma::mat xi_Y(T, 1, arma::fill::zeros) ;
   arma::mat xi_X(T, p, arma::fill::zeros) ;
-  arma::mat fit(T, N, arma::fill::zeros) ;
-  double sigma2 = 0 ;
-  double IC = 0 ;
 
-  arma::mat invXX ;
-  //arma::mat subX(T, N, arma::fill::zeros) ;
+  GramSolver gram ; // factorization of X'X
 
   /* duplicate data */
-  arma::mat YY = Y;
-  arma::cube XX = X;
-
-  
-  // mu_X 
-  if (p > 0) {
-    for (int i = 0; i < p; i++) {
-      mu_X(i,0)  =  accu(XX.slice(i))/(N*T) ;
-      if (force == 0) {
-        XX.slice(i) =  XX.slice(i)- mu_X(i,0) ;
-      }
-    }
-  }
+  arma::mat YY ;
+  arma::cube XX ;
+  panel_gather(YY, XX, Y, X, units) ;
 
-  /* unit fixed effects */
-  if (force == 1) {
-    if (p > 0) {
-      for (int i = 0; i < p; i++) {
-        alpha_X.col(i)  = mean(XX.slice(i), 0).t(); // colMeans 
-        XX.slice(i) = XX.slice(i) - repmat(alpha_X.col(i).t(), T, 1) ;
-      }
-    } 
-  }
   
-  /* time fixed effects  */
-  if (force == 2) {
-    if (p > 0) {
-      for (int i = 0; i < p; i++) {
-        xi_X.col(i)  =  mean(XX.slice(i), 1) ; //rowMeans
-        XX.slice(i) =  XX.slice(i) - repmat(xi_X.col(i), 1, N) ;
-      }
-    }  
-  }
-
-  if (force == 3) {
-    if (p > 0) {
-      for (int i = 0; i < p; i++) {
-        alpha_X.col(i)  = mean(XX.slice(i), 0).t(); // colMeans 
-        xi_X.col(i)  =  mean(XX.slice(i), 1) ; //rowMeans
-        XX.slice(i) = XX.slice(i) - repmat(alpha_X.col(i).t(), T, 1) 
-          - repmat(xi_X.col(i), 1, N) + mu_X(i,0) ;
-      }
-    }
-  }
+  /* grand mean, unit and time means of every covariate */
+  twoway_demean_cube(XX, force, 0, mu_X, alpha_X, xi_X) ;
 
   /* check if XX has enough variation */
   int p1 = p; 
@@ -1323,36 +2905,101 @@ List inter_fe_ub (arma::mat Y,
     j++;
   }
 
+  /* ... and no covariate is collinear with the others */
+  p1 = shed_collinear(XX, mu_X, alpha_X, xi_X, X_invar, gram) ;
+
   int validX = 1 ;
   if(p1==0){
     validX = 0 ;
-    if (force == 0 && r == 0) { // no covariate and force == 0 and r == 0 
-      mu_Y = accu(YY)/obs ;
-      mu = mu_Y ;
-      YY = FE_adj(YY - mu_Y, I) ;
-    }
   }
 
+  prep.y.YY = std::move(YY) ;
+  prep.y.mu_Y = 0 ;
+  prep.x.XX = std::move(XX) ;
+  prep.x.mu_X = mu_X ;
+  prep.x.alpha_X = alpha_X ;
+  prep.x.xi_X = xi_X ;
+  prep.x.X_invar = X_invar ;
+  prep.x.gram = gram ;
+  prep.x.p1 = p1 ;
+  prep.x.validX = validX ;
+}
+
+/* Interactive Fixed Effects: ub, fit with r factors on a prepared panel,
+   covariate side x and outcome side y (the raw outcome) */
+InterFit inter_fe_ub_solve (const CovarPrep& x,
+                            const OutcomePrep& y,
+                            int r, // r > 0, the outcome has a factor-type fixed effect; r = 0 else
+                            int force,
+                            const IterControl& ctl,
+                            const FactorEngine& engine,
+                            const arma::mat& factor0 // warm start, may be empty
+                            ) {
+  const arma::mat& I = x.I ;
+  const arma::cube& XX = x.XX ;
+  const arma::mat& X_invar = x.X_invar ;
+  const GramSolver& gram = x.gram ;
+  const arma::mat& mu_X = x.mu_X ;
+  const arma::mat& alpha_X = x.alpha_X ;
+  const arma::mat& xi_X = x.xi_X ;
+  int p1 = x.p1 ;
+  int validX = x.validX ;
+
+  /* Dimensions */
+  int T = I.n_rows ;
+  int N = I.n_cols ;
+  int p = X_invar.n_rows ;
+  double obs = accu(I) ;
+  int niter = 0 ;
+  IterTrace iters ;
+  double saved = 0 ;
+  arma::mat factor ;
+  arma::mat lambda ;
+  arma::mat VNT ;
+  arma::mat beta ; 
+  arma::mat U ;
+  double mu_Y = 0 ;
+  double mu = 0 ;
+  arma::mat alpha(N, 1, arma::fill::zeros) ;
+  arma::mat xi(T, 1, arma::fill::zeros) ;
+  arma::mat fit(T, N, arma::fill::zeros) ;
+  double sigma2 = 0 ;
+  double IC = 0 ;
+
+  /* no covariate and force == 0 and r == 0: take out the grand mean */
+  arma::mat YY_adj ;
+  if (p1 == 0 && force == 0 && r == 0) {
+    mu_Y = accu(y.YY)/obs ;
+    mu = mu_Y ;
+    YY_adj = FE_adj(y.YY - mu_Y, I) ;
+  }
+  const arma::mat& YY = YY_adj.n_elem > 0 ? YY_adj : y.YY ;
+
+  const arma::mat& F0 = factor0 ; // warm start, e.g. from a previous em step
+
   /* Main Algorithm */ 
   if (p1 == 0) {
     if (r > 0) {
       // add fe ; inter fe ; iteration
-      List fe_ad_inter = fe_ad_inter_iter(YY, I, force, 0, r, 0, tol) ;
-      mu = as<double>(fe_ad_inter["mu"]) ;
-      U = as<arma::mat>(fe_ad_inter["e"]) ;
-      fit = as<arma::mat>(fe_ad_inter["fit"]) ;
+      IterFit fe_ad_inter = fe_ad_inter_iter_core(YY, I, force, 0, r, 0, ctl,
+                                                  F0, engine) ;
+      mu = fe_ad_inter.fe.mu ;
+      U = fe_ad_inter.e ;
+      fit = fe_ad_inter.fit ;
 
-      factor = as<arma::mat>(fe_ad_inter["factor"]) ;
-      lambda = as<arma::mat>(fe_ad_inter["lambda"]) ;
-      VNT = as<arma::mat>(fe_ad_inter["VNT"]) ;
+      factor = fe_ad_inter.factor ;
+      lambda = fe_ad_inter.lambda ;
+      VNT = fe_ad_inter.VNT ;
 
       if (force==1||force==3) {
-        alpha = as<arma::mat>(fe_ad_inter["alpha"]) ;
+        alpha = fe_ad_inter.fe.alpha ;
       }
       if (force==2||force==3) {
-        xi = as<arma::mat>(fe_ad_inter["xi"]) ;
+        xi = fe_ad_inter.fe.xi ;
       }
-      niter = as<int>(fe_ad_inter["niter"]) ;
+      niter = fe_ad_inter.niter ;
+      iters = fe_ad_inter.trace ;
+      saved = fe_ad_inter.saved ;
     } 
     else {
       if (force==0) {
@@ -1360,64 +3007,69 @@ List inter_fe_ub (arma::mat Y,
         fit.fill(mu) ;
       } else {
         // add fe; iteration
-        List fe_ad = fe_ad_iter(YY, I, force, tol) ;
-        mu = as<double>(fe_ad["mu"]) ;
-        U = as<arma::mat>(fe_ad["e"]) ;
-        fit = as<arma::mat>(fe_ad["fit"]) ;
+        IterFit fe_ad = fe_ad_iter_core(YY, I, force, ctl) ;
+        mu = fe_ad.fe.mu ;
+        U = fe_ad.e ;
+        fit = fe_ad.fit ;
         if (force==1||force==3) {
-          alpha = as<arma::mat>(fe_ad["alpha"]) ;
+          alpha = fe_ad.fe.alpha ;
         }
         if (force==2||force==3) {
-          xi = as<arma::mat>(fe_ad["xi"]) ;
+          xi = fe_ad.fe.xi ;
         }
-        niter = as<int>(fe_ad["niter"]) ;
+        niter = fe_ad.niter ;
+        iters = fe_ad.trace ;
+        saved = fe_ad.saved ;
       }
     } 
   } 
   else {
     /* starting value:  the OLS estimator */
-    invXX = XXinv(XX) ; // compute (X'X)^{-1}, outside beta iteration 
     if (r==0) {
       // add fe, covar; iteration
-      List fe_ad = fe_ad_covar_iter(XX, invXX, alpha_X, xi_X, mu_X,
-                                    YY, I, force, tol) ;
-      mu = as<double>(fe_ad["mu"]) ;
-      beta = as<arma::mat>(fe_ad["beta"]) ;
-      U = as<arma::mat>(fe_ad["e"]) ;
-      fit = as<arma::mat>(fe_ad["fit"]) ;
+      IterFit fe_ad = fe_ad_covar_iter_core(XX, gram, alpha_X, xi_X, mu_X,
+                                            YY, I, force, ctl) ;
+      mu = fe_ad.fe.mu ;
+      beta = fe_ad.beta ;
+      U = fe_ad.e ;
+      fit = fe_ad.fit ;
       if (force==1||force==3) {
-        alpha = as<arma::mat>(fe_ad["alpha"]) ;
+        alpha = fe_ad.fe.alpha ;
       }
       if (force==2||force==3) {
-        xi = as<arma::mat>(fe_ad["xi"]) ;
+        xi = fe_ad.fe.xi ;
       }
-      niter = as<int>(fe_ad["niter"]) ;
+      niter = fe_ad.niter ;
+      iters = fe_ad.trace ;
+      saved = fe_ad.saved ;
     } 
     else if (r > 0) {       
       // add, covar, interactive, iteration
-      List fe_ad_inter_covar = fe_ad_inter_covar_iter(XX, invXX,
-               alpha_X, xi_X, mu_X, YY, I, force, 0, r, 0, tol) ;
-      mu = as<double>(fe_ad_inter_covar["mu"]) ;
-      beta = as<arma::mat>(fe_ad_inter_covar["beta"]) ;
-      U = as<arma::mat>(fe_ad_inter_covar["e"]) ;
-      fit = as<arma::mat>(fe_ad_inter_covar["fit"]) ;
+      IterFit fe_ad_inter_covar = fe_ad_inter_covar_iter_core(XX, gram,
+               alpha_X, xi_X, mu_X, YY, I, force, 0, r, 0, ctl, F0, engine) ;
+      mu = fe_ad_inter_covar.fe.mu ;
+      beta = fe_ad_inter_covar.beta ;
+      U = fe_ad_inter_covar.e ;
+      fit = fe_ad_inter_covar.fit ;
 
-      factor = as<arma::mat>(fe_ad_inter_covar["factor"]) ;
-      lambda = as<arma::mat>(fe_ad_inter_covar["lambda"]) ;
-      VNT = as<arma::mat>(fe_ad_inter_covar["VNT"]) ;
+      factor = fe_ad_inter_covar.factor ;
+      lambda = fe_ad_inter_covar.lambda ;
+      VNT = fe_ad_inter_covar.VNT ;
 
       if (force==1||force==3) {
-        alpha = as<arma::mat>(fe_ad_inter_covar["alpha"]) ;
+        alpha = fe_ad_inter_covar.fe.alpha ;
       }
       if (force==2||force==3) {
-        xi = as<arma::mat>(fe_ad_inter_covar["xi"]) ;
+        xi = fe_ad_inter_covar.fe.xi ;
       }
-      niter = as<int>(fe_ad_inter_covar["niter"]) ;
+      niter = fe_ad_inter_covar.niter ;
+      iters = fe_ad_inter_covar.trace ;
+      saved = fe_ad_inter_covar.saved ;
     }
   } 
     
   /* sigma2 and IC */
-  sigma2 = trace(U * U.t())/ (obs - r * (N + T) + pow(double(r),2) - p1 ) ;
+  sigma2 = accu(arma::square(U))/ (obs - r * (N + T) + pow(double(r),2) - p1 ) ;
 
   IC = log(sigma2) + (r * ( N + T ) - pow(double(r),2) + p1)
    * log ( obs ) / ( obs ) ;
@@ -1426,75 +3078,271 @@ List inter_fe_ub (arma::mat Y,
   // Storage
   //-------------------------------# 
 
-  List output ;
-  // output["p1"] = p1 ;
-  // output["beta_valid"] = beta ;
+  InterFit out ;
+  out.p1 = p1 ;
 
   if(p>0) {
-    // output["beta_valid"] = beta ;
     arma::mat beta_total(p,1);
-    // arma::mat beta_tot(p,1);
 
     if(p>p1) {
       int j4= 0;
       for(int i=0; i<p; i++) {
         if(X_invar(i,0)==1) {
           beta_total(i,0) = arma::datum::nan;
-          // beta_tot(i,0) = 0;
         }
         else {
           beta_total(i,0) = beta(j4,0);
-          // beta_tot(i,0) = beta(j4,0);
           j4++;
         }
       }
     }
     else {
       beta_total = beta;
-      // beta_tot = beta;
     }
-    output["beta"] = beta_total;
-    // output["beta_tot"] = beta_tot;
-  }
+    out.beta = beta_total;
+  }
+
+  out.mu = mu ;
+  out.fit = fit ;
+  out.niter = niter ;
+  out.trace = iters ;
+  out.saved = saved ;
+  out.alpha = alpha ;
+  out.xi = xi ;
+  out.factor = factor ;
+  out.lambda = lambda ;
+  out.VNT = VNT ;
+  out.residuals = U ;
+  out.sigma2 = sigma2 ;
+  out.IC = IC ;
+  out.validX = validX ;
+  return(out);
+}
+
+/* Interactive Fixed Effects: ub */
+InterFit inter_fe_ub_core (const arma::mat& Y,
+                           const arma::cube& X,
+                           const arma::mat& I_data,
+                           int r, // r > 0, the outcome has a factor-type fixed effect; r = 0 else
+                           int force,
+                           const IterControl& ctl,
+                           const FactorEngine& engine,
+                           const arma::mat& factor0, // warm start, may be empty
+                           const arma::uvec& units // columns to use, empty for all
+                           ) {
+  PanelPrep prep ;
+  inter_fe_ub_prep(prep, Y, X, I_data, force, units) ;
+  return(inter_fe_ub_solve(prep.x, prep.y, r, force, ctl, engine, factor0)) ;
+}
 
-  output["mu"] = mu ;   
-  output["fit"] = fit ;  
+/* the List returned by inter_fe_ub */
+List inter_fe_ub_output (const InterFit& est, int p, int r, int force) {
+  List output ;
+
+  if (p > 0) {
+    output["beta"] = est.beta ;
+  }
+  output["mu"] = est.mu ;   
+  output["fit"] = est.fit ;  
 
-  if ( !(force == 0 && r == 0 && p1 == 0) ) {
-    output["niter"] = niter ;
+  if ( !(force == 0 && r == 0 && est.p1 == 0) ) {
+    output["niter"] = est.niter ;
+    output["niter.saved"] = est.saved ;
   }
   if (force ==1 || force == 3) {
-    output["alpha"] = alpha ;
+    output["alpha"] = est.alpha ;
   }
   if (force ==2 || force == 3) {
-    output["xi"] = xi ;
+    output["xi"] = est.xi ;
   }
   if (r > 0) {
-    output["factor"] = factor ;
-    output["lambda"] = lambda ;
-    output["VNT"] = VNT ;
-    //FE = factor * lambda.t() ;
-    //output["FE"] = FE ;
+    output["factor"] = est.factor ;
+    output["lambda"] = est.lambda ;
+    output["VNT"] = est.VNT ;
+  }
+  output["residuals"] = est.residuals ;
+  output["sigma2"] = est.sigma2 ;
+  output["IC"] = est.IC ;
+  output["validX"] = est.validX ;
+  if (est.trace.step.size() > 0) {
+    output["trace"] = trace_output(est.trace) ;
   }
-  output["residuals"] = U ;
-  output["sigma2"] = sigma2 ;
-  output["IC"] = IC;
-  output["validX"] = validX;
   return(output);
- 
 }
 
-
-/* Interactive Fixed Effects: matrix completion */
 // [[Rcpp::export]]
-List inter_fe_mc (arma::mat Y,
-                  arma::cube X,
-                  arma::mat I,
+List inter_fe_ub (const arma::mat& Y,
+                  const arma::cube& X,
+                  const arma::mat& I,
                   int r, // r > 0, the outcome has a factor-type fixed effect; r = 0 else
-                  double lambda,
                   int force,
-                  double tol = 1e-5
+                  double tol = 1e-5,
+                  int svd_method = 0, // factor engine, see panel_factor
+                  int oversample = 10,
+                  int power = 2,
+                  int precision = 0, // 1: factor extraction in single precision
+                  Rcpp::Nullable<Rcpp::NumericMatrix> factor0 = R_NilValue, // warm start
+                  Rcpp::Nullable<Rcpp::List> control = R_NilValue // see iter_control
                   ) {
+  FactorEngine engine = {svd_method, oversample, power, precision} ;
+  IterControl ctl = iter_control(tol, control) ;
+  arma::mat F0 ;
+  if (factor0.isNotNull()) {
+    F0 = as<arma::mat>(factor0.get()) ;
+  }
+  InterFit est = inter_fe_ub_core(Y, X, I, r, force, ctl, engine, F0,
+                                  arma::uvec()) ;
+  return(inter_fe_ub_output(est, X.n_slices, r, force)) ;
+}
+
+
+/* inter_fe (or inter_fe_ub if I has missing cells) for every r in
+   r_min, ..., r_max from one data preparation: the demeaning, the
+   covariate checks and the factorization of X'X are shared by all r.
+   Without covariates in a balanced panel the factors of each r are
+   the leading columns of one r_max decomposition, which is exactly
+   what a separate fit computes. Every other fit is iterative and
+   starts from beta0, as a separate call of inter_fe / inter_fe_ub
+   would, so the fits (and the r chosen by cross-validation) do not
+   depend on the path. A list of the fits, in the format of inter_fe /
+   inter_fe_ub */
+// [[Rcpp::export]]
+List inter_fe_path (const arma::mat& Y,
+                    const arma::cube& X,
+                    const arma::mat& I,
+                    int r_min,
+                    int r_max,
+                    int force,
+                    const arma::mat& beta0,
+                    double tol = 1e-5,
+                    int precision = 0 // 1: factor extraction in single precision
+                    ) {
+  FactorEngine engine = {0, 10, 2, precision} ;
+  IterControl ctl = iter_control(tol) ;
+  int p = X.n_slices ;
+  int ub = arma::any(arma::vectorise(I) == 0) ; // unbalanced panel
+
+  PanelPrep prep ;
+  if (ub == 0) {
+    inter_fe_prep(prep, Y, X, force, arma::uvec()) ;
+    if (prep.x.p1 == 0 && r_max > 0) {
+      arma::mat VNT ;
+      factor_extract(prep.y.YY, r_max, engine, prep.y.factor, prep.y.lambda,
+                     VNT, arma::mat()) ;
+      prep.y.eig = VNT.diag() ;
+    }
+  }
+  else {
+    inter_fe_ub_prep(prep, Y, X, I, force, arma::uvec()) ;
+  }
+
+  List output(r_max - r_min + 1) ;
+  for (int r = r_min; r <= r_max; r++) {
+    if (ub == 0) {
+      InterFit est = inter_fe_solve(prep.x, prep.y, r, force, beta0, ctl,
+                                    engine, arma::mat()) ;
+      output[r - r_min] = inter_fe_output(est, p, r, force) ;
+    }
+    else {
+      InterFit est = inter_fe_ub_solve(prep.x, prep.y, r, force, ctl,
+                                       engine, arma::mat()) ;
+      output[r - r_min] = inter_fe_ub_output(est, p, r, force) ;
+    }
+  }
+  return(output) ;
+}
+
+
+/* inter_fe (or inter_fe_ub if I has missing cells) of each outcome
+   Y(, , k) on the same covariates X. What depends on X alone (its
+   demeaning, the checks for invariant and collinear covariates, the
+   factorization of X'X) is prepared once and read by every task
+   through a const reference; the outcomes are then fitted as
+   independent tasks on an OpenMP team of "cores" threads, each owning
+   only its outcome side (the outcome, its means and the fit). A list
+   of the fits, in the format of inter_fe / inter_fe_ub, NULL where a
+   fit failed */
+// [[Rcpp::export]]
+List inter_fe_multi (const arma::cube& Y, // T * N * K outcomes
+                     const arma::cube& X,
+                     const arma::mat& I,
+                     int r,
+                     int force,
+                     const arma::mat& beta0,
+                     double tol = 1e-5,
+                     int precision = 0, // 1: factor extraction in single precision
+                     int cores = 1
+                     ) {
+  FactorEngine engine = {0, 10, 2, precision} ;
+  IterControl ctl = iter_control(tol) ;
+  int K = Y.n_slices ;
+  int p = X.n_slices ;
+  int ub = arma::any(arma::vectorise(I) == 0) ; // unbalanced panel
+  if (K == 0) {
+    return(List()) ;
+  }
+
+  /* the covariate side, shared; the outcome side of the first
+     outcome is dropped, each task prepares its own */
+  PanelPrep shared ;
+  if (ub == 0) {
+    inter_fe_prep(shared, Y.slice(0), X, force, arma::uvec()) ;
+  }
+  else {
+    inter_fe_ub_prep(shared, Y.slice(0), X, I, force, arma::uvec()) ;
+  }
+  shared.y = OutcomePrep() ;
+  const CovarPrep& x = shared.x ;
+
+  std::vector<InterFit> est(K) ;
+  std::vector<int> ok(K, 0) ;
+
+  int nthreads = thread_count(cores) ;
+  #pragma omp parallel for num_threads(nthreads) schedule(dynamic) if(nthreads > 1)
+  for (int k = 0; k < K; k++) {
+    try {
+      OutcomePrep y ;
+      y.YY = Y.slice(k) ;
+      if (ub == 0) {
+        inter_fe_prep_y(y, force) ;
+        est[k] = inter_fe_solve(x, y, r, force, beta0, ctl, engine,
+                                arma::mat()) ;
+      }
+      else {
+        est[k] = inter_fe_ub_solve(x, y, r, force, ctl, engine,
+                                   arma::mat()) ;
+      }
+      ok[k] = 1 ;
+    } catch (...) {
+      // leave the outcome out; exceptions must not leave the thread
+    }
+  }
+
+  List output(K) ;
+  for (int k = 0; k < K; k++) {
+    if (ok[k] == 0) {
+      continue ;
+    }
+    if (ub == 0) {
+      output[k] = inter_fe_output(est[k], p, r, force) ;
+    }
+    else {
+      output[k] = inter_fe_ub_output(est[k], p, r, force) ;
+    }
+  }
+  return(output) ;
+}
+
+/* Interactive Fixed Effects: matrix completion */
+InterFit inter_fe_mc_core (const arma::mat& Y,
+                           const arma::cube& X,
+                           const arma::mat& I,
+                           int r, // r > 0, the outcome has a factor-type fixed effect; r = 0 else
+                           double lambda,
+                           int force,
+                           const IterControl& ctl,
+                           IterFit* warm // in: fit at the previous lambda, out: this fit; or NULL
+                           ) {
   
   /* Dimensions */
   int T = Y.n_rows ;
@@ -1502,6 +3350,8 @@ List inter_fe_mc (arma::mat Y,
   int p = X.n_slices ;
   double obs = accu(I) ;
   int niter = 0 ;
+  IterTrace iters ;
+  double saved = 0 ;
   int validF = 1 ;
   //arma::mat factor ;
   //arma::mat lambda ;
@@ -1523,53 +3373,15 @@ List inter_fe_mc (arma::mat Y,
   double sigma2 = 0;
   //double IC ;
 
-  arma::mat invXX ;
+  GramSolver gram ; // factorization of X'X
   //arma::mat subX(T, N, arma::fill::zeros) ;
 
   /* duplicate data */
   arma::mat YY = Y;
   arma::cube XX = X;
 
-  // mu_X 
-  if (p > 0) {
-    for (int i = 0; i < p; i++) {
-      mu_X(i,0)  =  accu(XX.slice(i))/(N*T) ;
-      if (force == 0) {
-        XX.slice(i) =  XX.slice(i)- mu_X(i,0) ;
-      }
-    }
-  }
-
-  /* unit fixed effects */
-  if (force == 1) {
-    if (p > 0) {
-      for (int i = 0; i < p; i++) {
-        alpha_X.col(i)  = mean(XX.slice(i), 0).t(); // colMeans 
-        XX.slice(i) = XX.slice(i) - repmat(alpha_X.col(i).t(), T, 1) ;
-      }
-    } 
-  }
-  
-  /* time fixed effects  */
-  if (force == 2) {
-    if (p > 0) {
-      for (int i = 0; i < p; i++) {
-        xi_X.col(i)  =  mean(XX.slice(i), 1) ; //rowMeans
-        XX.slice(i) =  XX.slice(i) - repmat(xi_X.col(i), 1, N) ;
-      }
-    }  
-  }
-
-  if (force == 3) {
-    if (p > 0) {
-      for (int i = 0; i < p; i++) {
-        alpha_X.col(i)  = mean(XX.slice(i), 0).t(); // colMeans 
-        xi_X.col(i)  =  mean(XX.slice(i), 1) ; //rowMeans
-        XX.slice(i) = XX.slice(i) - repmat(alpha_X.col(i).t(), T, 1) 
-          - repmat(xi_X.col(i), 1, N) + mu_X(i,0) ;
-      }
-    }
-  }
+  /* grand mean, unit and time means of every covariate */
+  twoway_demean_cube(XX, force, 0, mu_X, alpha_X, xi_X) ;
 
   /* check if XX has enough variation */
   int p1 = p; 
@@ -1590,6 +3402,9 @@ List inter_fe_mc (arma::mat Y,
     j++;
   }
 
+  /* ... and no covariate is collinear with the others */
+  p1 = shed_collinear(XX, mu_X, alpha_X, xi_X, X_invar, gram) ;
+
   int validX = 1 ;
   if(p1==0){
     validX = 0 ;
@@ -1601,21 +3416,29 @@ List inter_fe_mc (arma::mat Y,
   }
 
   /* Main Algorithm */ 
+  FactorEngine engine = {0, 10, 2} ; // mc path: exact soft-thresholding
   if (p1 == 0) {
     if (r > 0) {
       // add fe ; inter fe ; iteration
-      List fe_ad_inter = fe_ad_inter_iter(YY, I, force, 1, 0, lambda, tol) ;
-      mu = as<double>(fe_ad_inter["mu"]) ;
-      U = as<arma::mat>(fe_ad_inter["e"]) ;
-      fit = as<arma::mat>(fe_ad_inter["fit"]) ;
+      IterFit fe_ad_inter = fe_ad_inter_iter_core(YY, I, force, 1, 0, lambda,
+                                                  ctl, arma::mat(), engine,
+                                                  warm) ;
+      if (warm != NULL) {
+        *warm = fe_ad_inter ;
+      }
+      mu = fe_ad_inter.fe.mu ;
+      U = fe_ad_inter.e ;
+      fit = fe_ad_inter.fit ;
       if (force==1||force==3) {
-        alpha = as<arma::mat>(fe_ad_inter["alpha"]) ;
+        alpha = fe_ad_inter.fe.alpha ;
       }
       if (force==2||force==3) {
-        xi = as<arma::mat>(fe_ad_inter["xi"]) ;
+        xi = fe_ad_inter.fe.xi ;
       }
-      niter = as<int>(fe_ad_inter["niter"]) ;
-      validF = as<int>(fe_ad_inter["validF"]) ;
+      niter = fe_ad_inter.niter ;
+      iters = fe_ad_inter.trace ;
+      saved = fe_ad_inter.saved ;
+      validF = fe_ad_inter.validF ;
     } 
     else {
       if (force==0) {
@@ -1624,57 +3447,66 @@ List inter_fe_mc (arma::mat Y,
         validF = 0 ;
       } else {
         // add fe; iteration
-        List fe_ad = fe_ad_iter(YY, I, force, tol) ;
-        mu = as<double>(fe_ad["mu"]) ;
-        U = as<arma::mat>(fe_ad["e"]) ;
-        fit = as<arma::mat>(fe_ad["fit"]) ;
+        IterFit fe_ad = fe_ad_iter_core(YY, I, force, ctl) ;
+        mu = fe_ad.fe.mu ;
+        U = fe_ad.e ;
+        fit = fe_ad.fit ;
         if (force==1||force==3) {
-          alpha = as<arma::mat>(fe_ad["alpha"]) ;
+          alpha = fe_ad.fe.alpha ;
         }
         if (force==2||force==3) {
-          xi = as<arma::mat>(fe_ad["xi"]) ;
+          xi = fe_ad.fe.xi ;
         }
-        niter = as<int>(fe_ad["niter"]) ;
+        niter = fe_ad.niter ;
+        iters = fe_ad.trace ;
+        saved = fe_ad.saved ;
         validF = 0 ;
       }
     } 
   } 
   else {
     /* starting value:  the OLS estimator */
-    invXX = XXinv(XX) ; // compute (X'X)^{-1}, outside beta iteration 
     if (r==0) {
       // add fe, covar; iteration
-      List fe_ad = fe_ad_covar_iter(XX, invXX, alpha_X, xi_X, mu_X,
-                                    YY, I, force, tol) ;
-      mu = as<double>(fe_ad["mu"]) ;
-      beta = as<arma::mat>(fe_ad["beta"]) ;
-      U = as<arma::mat>(fe_ad["e"]) ;
-      fit = as<arma::mat>(fe_ad["fit"]) ;
+      IterFit fe_ad = fe_ad_covar_iter_core(XX, gram, alpha_X, xi_X, mu_X,
+                                            YY, I, force, ctl) ;
+      mu = fe_ad.fe.mu ;
+      beta = fe_ad.beta ;
+      U = fe_ad.e ;
+      fit = fe_ad.fit ;
       if (force==1||force==3) {
-        alpha = as<arma::mat>(fe_ad["alpha"]) ;
+        alpha = fe_ad.fe.alpha ;
       }
       if (force==2||force==3) {
-        xi = as<arma::mat>(fe_ad["xi"]) ;
+        xi = fe_ad.fe.xi ;
       }
-      niter = as<int>(fe_ad["niter"]) ;
+      niter = fe_ad.niter ;
+      iters = fe_ad.trace ;
+      saved = fe_ad.saved ;
       validF = 0 ;
     } 
     else if (r > 0) {       
       // add, covar, interactive, iteration
-      List fe_ad_inter_covar = fe_ad_inter_covar_iter(XX, invXX,
-               alpha_X, xi_X, mu_X, YY, I, force, 1, 0, lambda, tol) ;
-      mu = as<double>(fe_ad_inter_covar["mu"]) ;
-      beta = as<arma::mat>(fe_ad_inter_covar["beta"]) ;
-      U = as<arma::mat>(fe_ad_inter_covar["e"]) ;
-      fit = as<arma::mat>(fe_ad_inter_covar["fit"]) ;
+      IterFit fe_ad_inter_covar = fe_ad_inter_covar_iter_core(XX, gram,
+               alpha_X, xi_X, mu_X, YY, I, force, 1, 0, lambda, ctl,
+               arma::mat(), engine, warm) ;
+      if (warm != NULL) {
+        *warm = fe_ad_inter_covar ;
+      }
+      mu = fe_ad_inter_covar.fe.mu ;
+      beta = fe_ad_inter_covar.beta ;
+      U = fe_ad_inter_covar.e ;
+      fit = fe_ad_inter_covar.fit ;
       if (force==1||force==3) {
-        alpha = as<arma::mat>(fe_ad_inter_covar["alpha"]) ;
+        alpha = fe_ad_inter_covar.fe.alpha ;
       }
       if (force==2||force==3) {
-        xi = as<arma::mat>(fe_ad_inter_covar["xi"]) ;
+        xi = fe_ad_inter_covar.fe.xi ;
       }
-      niter = as<int>(fe_ad_inter_covar["niter"]) ;
-      validF = as<int>(fe_ad_inter_covar["validF"]) ;
+      niter = fe_ad_inter_covar.niter ;
+      iters = fe_ad_inter_covar.trace ;
+      saved = fe_ad_inter_covar.saved ;
+      validF = fe_ad_inter_covar.validF ;
     }
   } 
     
@@ -1685,54 +3517,131 @@ List inter_fe_mc (arma::mat Y,
   // Storage
   //-------------------------------# 
 
-  List output ;
-  // output["p1"] = p1 ;
-  // output["beta_valid"] = beta ;
+  InterFit out ;
+  out.p1 = p1 ;
 
   if(p>0) {
-    // output["beta_valid"] = beta ;
     arma::mat beta_total(p,1);
-    // arma::mat beta_tot(p,1);
 
     if(p>p1) {
       int j4= 0;
       for(int i=0; i<p; i++) {
         if(X_invar(i,0)==1) {
           beta_total(i,0) = arma::datum::nan;
-          // beta_tot(i,0) = 0;
         }
         else {
           beta_total(i,0) = beta(j4,0);
-          // beta_tot(i,0) = beta(j4,0);
           j4++;
         }
       }
     }
     else {
       beta_total = beta;
-      // beta_tot = beta;
     }
-    output["beta"] = beta_total;
-    // output["beta_tot"] = beta_tot;
-  }
+    out.beta = beta_total;
+  }
+
+  out.mu = mu ;
+  out.fit = fit ;
+  out.validF = validF ;
+  out.niter = niter ;
+  out.trace = iters ;
+  out.saved = saved ;
+  out.alpha = alpha ;
+  out.xi = xi ;
+  out.residuals = U ;
+  out.sigma2 = sigma2 ;
+  out.validX = validX ;
+  return(out);
+}
+
+// [[Rcpp::export]]
+List inter_fe_mc (const arma::mat& Y,
+                  const arma::cube& X,
+                  const arma::mat& I,
+                  int r, // r > 0, the outcome has a factor-type fixed effect; r = 0 else
+                  double lambda,
+                  int force,
+                  double tol = 1e-5,
+                  Rcpp::Nullable<Rcpp::List> control = R_NilValue // see iter_control
+                  ) {
+  IterControl ctl = iter_control(tol, control) ;
+  InterFit est = inter_fe_mc_core(Y, X, I, r, lambda, force, ctl, NULL) ;
+
+  List output ;
 
-  output["mu"] = mu ;   
-  output["fit"] = fit ; 
-  output["validF"] = validF ; 
+  if (X.n_slices > 0) {
+    output["beta"] = est.beta ;
+  }
+  output["mu"] = est.mu ;   
+  output["fit"] = est.fit ; 
+  output["validF"] = est.validF ; 
 
-  if ( !(force == 0 && r == 0 && p1 == 0) ) {
-    output["niter"] = niter ;
+  if ( !(force == 0 && r == 0 && est.p1 == 0) ) {
+    output["niter"] = est.niter ;
+    output["niter.saved"] = est.saved ;
   }
   if (force ==1 || force == 3) {
-    output["alpha"] = alpha ;
+    output["alpha"] = est.alpha ;
   }
   if (force ==2 || force == 3) {
-    output["xi"] = xi ;
+    output["xi"] = est.xi ;
+  }
+  output["residuals"] = est.residuals ;
+  output["sigma2"] = est.sigma2 ;
+  output["validX"] = est.validX ;
+  if (est.trace.step.size() > 0) {
+    output["trace"] = trace_output(est.trace) ;
   }
-  output["residuals"] = U ;
-  output["sigma2"] = sigma2 ;
-  output["validX"] = validX;
   return(output);
- 
 }
 
+/* matrix completion along a path of lambda: each lambda starts from
+   the solution at the previous one, so pass lambda decreasingly */
+// [[Rcpp::export]]
+List inter_fe_mc_path (const arma::mat& Y,
+                       const arma::cube& X,
+                       const arma::mat& I,
+                       int r,
+                       const arma::vec& lambda,
+                       int force,
+                       double tol = 1e-5
+                       ) {
+  int T = Y.n_rows ;
+  int N = Y.n_cols ;
+  int p = X.n_slices ;
+  int nlambda = lambda.n_elem ;
+  IterControl ctl = iter_control(tol) ;
+
+  arma::cube fit(T, N, nlambda) ;
+  arma::mat beta(p, nlambda) ;
+  arma::vec mu(nlambda) ;
+  arma::vec sigma2(nlambda) ;
+  IntegerVector niter(nlambda) ;
+  IntegerVector validF(nlambda) ;
+
+  IterFit warm ; // empty: the first lambda starts cold
+  for (int l = 0; l < nlambda; l++) {
+    InterFit est = inter_fe_mc_core(Y, X, I, r, lambda(l), force, ctl, &warm) ;
+    fit.slice(l) = est.fit ;
+    if (p > 0) {
+      beta.col(l) = est.beta ;
+    }
+    mu(l) = est.mu ;
+    sigma2(l) = est.sigma2 ;
+    niter[l] = est.niter ;
+    validF[l] = est.validF ;
+  }
+
+  List output ;
+  output["lambda"] = lambda ;
+  output["fit"] = fit ;
+  if (p > 0) {
+    output["beta"] = beta ;
+  }
+  output["mu"] = mu ;
+  output["sigma2"] = sigma2 ;
+  output["niter"] = niter ;
+  output["validF"] = validF ;
+  return(output) ;
+}
@@ -0,0 +1,374 @@
+# ifndef GSYNTH_INTERFE_H
+# define GSYNTH_INTERFE_H
+
+# include "gsynth_types.h"
+# include <RcppArmadillo.h>
+# include <vector>
+
+/* ******************* Data Structures  *********************** */
+
+/* rank-r factor extraction engine */
+struct FactorEngine {
+  int method ;     // 0: exact svd of the gram matrix; 1: randomized range finder;
+                   // 2: block power steps warm-started from previous factors
+  int oversample ; // extra columns in the random sketch
+  int power ;      // number of power iterations (steps when warm-started)
+  int precision ;  // exact engine: 0: double; 1: gram matrix and its eigen
+                   // decomposition in single precision
+} ;
+
+/* convergence control of the iterative estimators */
+struct IterControl {
+  int max_iter ;  // iteration budget, 0: each loop's own (see iter_budget)
+  double tol ;    // tolerance on the convergence measure
+  int criterion ; // 0: each loop's own scaled change; 1: change of the
+                  // iterate; 2: change relative to the iterate's norm
+  int accel ;     // 1: squarem on the iterates, see Squarem in interFE.cpp
+  int trace ;     // 1: record every iteration, see IterTrace
+} ;
+
+/* per-iteration record of an iterative estimator: residual sum of
+   squares at the observed cells, convergence measure, seconds */
+struct IterTrace {
+  std::vector<double> objective ;
+  std::vector<double> step ;
+  std::vector<double> time ;
+} ;
+
+/* low-rank matrix U * diagmat(d) * V', kept in factored form */
+struct LowRank {
+  arma::mat U ; // T * k
+  arma::vec d ; // k
+  arma::mat V ; // N * k
+} ;
+
+/* compressed (column-major) index of a subset of panel cells */
+struct CellIndex {
+  arma::umat loc ;    // 2 * n: row and column of each cell
+  arma::uvec colptr ; // N + 1: cells of column i are colptr(i), ..., colptr(i+1)-1
+} ;
+
+/* sparse plus low-rank matrix S + A * B', never formed densely */
+struct SpLowRank {
+  arma::sp_mat S ; // T * N
+  arma::mat A ;    // T * q
+  arma::mat B ;    // N * q
+} ;
+
+/* factorization of the p * p gram matrix X'X of the covariates */
+struct GramSolver {
+  int method ;     // 0: cholesky; 1: column-pivoted qr; 2: given inverse
+  int rank ;       // numerical rank of X'X
+  arma::mat R ;    // 0: upper cholesky factor; 1: R of the qr; 2: (X'X)^{-1}
+  arma::mat Q ;    // 1: Q of the qr
+  arma::uvec piv ; // 1: column pivots; the first rank columns are kept
+  arma::vec s ;    // 0, 1: column scales diag(X'X)^{-1/2}; R, Q factor D X'X D
+} ;
+
+/* scratch of the exact factor extraction: the gram matrix, its svd
+   and the lapack workspace. An iterative caller keeps one across its
+   steps, which then allocate nothing once the sizes are settled */
+struct FactorWork {
+  arma::mat D ;    // dense E, if E is sparse plus low-rank
+  arma::mat EE ;   // gram matrix, overwritten by the svd
+  arma::mat U ;    // its singular vectors
+  arma::vec s ;    // and values
+  arma::mat Vt ;
+  arma::vec work ;
+  arma::Col<arma::blas_int> iwork ;
+} ;
+
+/* scratch of the distance between two low-rank matrices, likewise */
+struct DistWork {
+  arma::mat U ;    // [A.U, B.U], overwritten by its qr
+  arma::mat V ;    // [A.V, B.V], likewise
+  arma::vec tau ;
+  arma::vec work ;
+} ;
+
+/* additive fixed effects mu + alpha_i + xi_t */
+struct AddFE {
+  double mu ;
+  arma::mat alpha ; // N * 1
+  arma::mat xi ;    // T * 1
+} ;
+
+/* result of one of the iterative estimators; the exported
+   functions convert it to a List, internal callers use it as is */
+struct IterFit {
+  AddFE fe ;
+  arma::mat beta ;
+  arma::mat fit ;
+  arma::mat e ;
+  arma::mat factor ;
+  arma::mat lambda ;
+  arma::mat VNT ;
+  LowRank G ; // mc: soft-thresholded interactive fe
+  int niter ;
+  double saved ; // accel: estimated iterations saved
+  IterTrace trace ;
+  int validF ;
+  IterFit () : niter(0), saved(0), validF(1) { fe.mu = 0 ; }
+} ;
+
+/* result of inter_fe / inter_fe_ub; beta has the length of the
+   original covariates, NaN for those that were dropped */
+struct InterFit {
+  double mu ;
+  arma::mat beta ;
+  arma::mat fit ; // inter_fe_ub only
+  arma::mat factor ;
+  arma::mat lambda ;
+  arma::mat VNT ;
+  arma::mat alpha ;
+  arma::mat xi ;
+  arma::mat residuals ;
+  double sigma2 ;
+  double IC ;
+  int niter ;
+  double saved ; // accel: estimated iterations saved
+  IterTrace trace ;
+  int validX ;
+  int validF ; // inter_fe_mc only
+  int p1 ; // number of covariates used
+  InterFit () : mu(0), sigma2(0), IC(0), niter(0), saved(0), validX(1),
+                validF(1), p1(0) {}
+} ;
+
+/* panel prepared for inter_fe / inter_fe_ub: what does not depend on
+   the number of factors, so fits for several r can share it. The
+   covariate side does not depend on the outcome either, so fits of
+   several outcomes share it too (inter_fe_multi) */
+struct CovarPrep {
+  arma::cube XX ;     // T * N * p1 demeaned covariates that are kept
+  arma::mat I ;       // T * N indicator (inter_fe_ub)
+  arma::mat mu_X ;
+  arma::mat alpha_X ;
+  arma::mat xi_X ;
+  arma::mat X_invar ; // p * 1, = 1 if the covariate was dropped
+  GramSolver gram ;   // factorization of X'X
+  int p1 ;
+  int validX ;
+  CovarPrep () : p1(0), validX(1) {}
+} ;
+
+struct OutcomePrep {
+  arma::mat YY ;      // T * N outcome, demeaned (inter_fe)
+  double mu_Y ;
+  arma::mat alpha_Y ;
+  arma::mat xi_Y ;
+  arma::mat factor ;  // optional, p1 == 0: leading factors of YY,
+  arma::mat lambda ;  // loadings and eigenvalues, reused for every
+  arma::vec eig ;     // r up to their number
+  OutcomePrep () : mu_Y(0) {}
+} ;
+
+struct PanelPrep {
+  CovarPrep x ;
+  OutcomePrep y ;
+} ;
+
+/* ******************* Internal Kernels  *********************** */
+
+/* control with tolerance tol, changed by the elements of the R list
+   control, if given: max.iter, tol, criterion ("legacy", "absolute"
+   or "relative"), accel, trace */
+IterControl iter_control (double tol,
+                          Rcpp::Nullable<Rcpp::List> control = R_NilValue) ;
+
+/* size of the OpenMP team for cores threads, under the cap of
+   set_thread_cap */
+int thread_count (int cores) ;
+
+/* the trace as a data frame */
+Rcpp::DataFrame trace_output (const IterTrace& trace) ;
+
+/* Inputs are taken by const reference and results are written into
+   caller-owned buffers. Armadillo keeps a buffer's memory when the
+   size is unchanged, so once the sizes are settled the iterations of
+   beta_iter_core, fe_ad_covar_iter_core, fe_ad_inter_iter_core (pac)
+   and panel_factor_ub allocate nothing, with the exact factor engine
+   in double precision. Scratch of p or r elements is the exception:
+   Armadillo keeps it inside the object for up to 16 elements.
+   tests/testthat/test-kernels.R checks this through arma_alloc_count.
+   The exported functions are thin wrappers. */
+
+/* cell index of the observed (Iij != 0) or missing (Iij == 0) cells */
+CellIndex cell_index (const arma::mat& I, bool observed) ;
+
+/* E(cells) = FE(cells) */
+void fill_cells (arma::mat& E, const arma::mat& FE, const CellIndex& cells) ;
+
+/* E(cells), in the order of the index */
+arma::vec cells_of (const arma::mat& E, const CellIndex& cells) ;
+
+/* E(cells) = v */
+void set_cells (arma::mat& E, const arma::vec& v, const CellIndex& cells) ;
+
+/* E(cells) = 0 */
+void zero_cells (arma::mat& E, const CellIndex& cells) ;
+
+/* two-way demeaning of the column-major T * N array y in place, in one
+   read and one write sweep: y - mu (force 0), y - alpha_i (1),
+   y - xi_t (2), y - alpha_i - xi_t + mu (3). mu, alpha (N) and xi (T)
+   receive the grand, column and row means; alpha and xi are zero where
+   force has no such effect and, if centred == 1, deviations from mu */
+void twoway_demean (double* y, int T, int N, int force, int centred,
+                    double& mu, double* alpha, double* xi) ;
+
+/* twoway_demean of every slice: mu_X (p * 1), alpha_X (N * p), xi_X (T * p) */
+void twoway_demean_cube (arma::cube& X, int force, int centred,
+                         arma::mat& mu_X, arma::mat& alpha_X,
+                         arma::mat& xi_X) ;
+
+/* remove grand mean / unit / time means from Y in place, as Y_demean */
+void demean_into (arma::mat& Y, double& mu_Y, arma::mat& alpha_Y,
+                  arma::mat& xi_Y, int force) ;
+
+/* add back what demean_into removed */
+void remean_into (arma::mat& Y, double mu_Y, const arma::mat& alpha_Y,
+                  const arma::mat& xi_Y, int force) ;
+
+/* fit = sum_k X_k * beta_k */
+void covar_fit_into (arma::mat& fit, const arma::cube& X,
+                     const arma::mat& beta) ;
+
+/* U = Y - sum_k X_k * beta_k */
+void covar_resid_into (arma::mat& U, const arma::mat& Y,
+                       const arma::cube& X, const arma::mat& beta) ;
+
+/* beta = (X'X)^{-1} (<X_k, R>)_k */
+void panel_beta_into (arma::mat& beta, const arma::cube& X,
+                      const GramSolver& gram, const arma::mat& R) ;
+
+/* YY = Y, XX = X restricted to units (all if empty) */
+void panel_gather (arma::mat& YY, arma::cube& XX, const arma::mat& Y,
+                   const arma::cube& X, const arma::uvec& units) ;
+
+/* xx = X'X */
+void gram_into (arma::mat& xx, const arma::cube& X) ;
+
+/* cholesky of xx, pivoted qr if xx is (nearly) singular */
+GramSolver gram_factor (const arma::mat& xx) ;
+
+/* wrap an explicit (X'X)^{-1} */
+GramSolver gram_inverse (const arma::mat& xxinv) ;
+
+/* beta = (X'X)^{-1} xy, basic solution if rank deficient */
+void gram_solve (arma::mat& beta, const GramSolver& gram, const arma::mat& xy) ;
+
+/* drop collinear covariates, mark them in X_invar; returns new p */
+int shed_collinear (arma::cube& XX, arma::mat& mu_X, arma::mat& alpha_X,
+                    arma::mat& xi_X, arma::mat& X_invar, GramSolver& gram) ;
+
+/* factors, loadings and eigenvalues of E */
+void factor_extract (const arma::mat& E, int r, const FactorEngine& engine,
+                     arma::mat& factor, arma::mat& lambda, arma::mat& VNT,
+                     const arma::mat& factor0) ;
+
+void factor_extract (const SpLowRank& E, int r, const FactorEngine& engine,
+                     arma::mat& factor, arma::mat& lambda, arma::mat& VNT,
+                     const arma::mat& factor0) ;
+
+/* the same with the scratch of the exact engine in work */
+void factor_extract (const arma::mat& E, int r, const FactorEngine& engine,
+                     arma::mat& factor, arma::mat& lambda, arma::mat& VNT,
+                     const arma::mat& factor0, FactorWork& work) ;
+
+void factor_extract (const SpLowRank& E, int r, const FactorEngine& engine,
+                     arma::mat& factor, arma::mat& lambda, arma::mat& VNT,
+                     const arma::mat& factor0, FactorWork& work) ;
+
+/* additive fe given the means of Y and X and beta */
+AddFE fe_add_core (const arma::mat& alpha_X, const arma::mat& xi_X,
+                   const arma::mat& mu_X, const arma::mat& alpha_Y,
+                   const arma::mat& xi_Y, double mu_Y, const arma::mat& beta,
+                   int T, int N, int force) ;
+
+/* T * N additive fe */
+arma::mat fe_add_dense (const AddFE& fe, int T, int N) ;
+
+/* ******************* Iterative Estimators  *********************** */
+
+/* additive fe by least squares over the observed cells; every unit
+   (period) with an effect needs an observed cell */
+IterFit fe_masked_core (const arma::mat& Y, const arma::mat& I, int force,
+                        const IterControl& ctl) ;
+
+/* fe_masked_core, or the em where an effect has no observed cell */
+IterFit fe_ad_iter_core (const arma::mat& Y, const arma::mat& I,
+                         int force, const IterControl& ctl) ;
+
+IterFit fe_ad_covar_iter_core (const arma::cube& XX, const GramSolver& gram,
+                               const arma::mat& alpha_X, const arma::mat& xi_X,
+                               const arma::mat& mu_X, const arma::mat& Y,
+                               const arma::mat& I, int force,
+                               const IterControl& ctl) ;
+
+IterFit fe_ad_inter_iter_core (const arma::mat& Y, const arma::mat& I,
+                               int force, int mc, int r, double lambda,
+                               const IterControl& ctl, const arma::mat& factor0,
+                               const FactorEngine& engine,
+                               const IterFit* warm = NULL) ;
+
+IterFit fe_ad_inter_covar_iter_core (const arma::cube& XX,
+                                     const GramSolver& gram,
+                                     const arma::mat& alpha_X,
+                                     const arma::mat& xi_X,
+                                     const arma::mat& mu_X,
+                                     const arma::mat& Y, const arma::mat& I,
+                                     int force, int mc, int r, double lambda,
+                                     const IterControl& ctl,
+                                     const arma::mat& factor0,
+                                     const FactorEngine& engine,
+                                     const IterFit* warm = NULL) ;
+
+IterFit beta_iter_core (const arma::cube& X, const GramSolver& gram,
+                        const arma::mat& Y, int r, const IterControl& ctl,
+                        const arma::mat& beta0, const arma::mat& factor0,
+                        const FactorEngine& engine) ;
+
+/* ******************* Estimators  *********************** */
+
+/* demean y.YY, the raw outcome, as inter_fe_prep does */
+void inter_fe_prep_y (OutcomePrep& y, int force) ;
+
+void inter_fe_prep (PanelPrep& prep, const arma::mat& Y,
+                    const arma::cube& X, int force, const arma::uvec& units) ;
+
+InterFit inter_fe_solve (const CovarPrep& x, const OutcomePrep& y,
+                         int r, int force,
+                         arma::mat beta0, const IterControl& ctl,
+                         const FactorEngine& engine,
+                         const arma::mat& factor0) ;
+
+void inter_fe_ub_prep (PanelPrep& prep, const arma::mat& Y,
+                       const arma::cube& X, const arma::mat& I_data,
+                       int force, const arma::uvec& units) ;
+
+InterFit inter_fe_ub_solve (const CovarPrep& x, const OutcomePrep& y,
+                            int r, int force,
+                            const IterControl& ctl, const FactorEngine& engine,
+                            const arma::mat& factor0) ;
+
+InterFit inter_fe_core (const arma::mat& Y, const arma::cube& X, int r,
+                        int force, const arma::mat& beta0,
+                        const IterControl& ctl, const FactorEngine& engine,
+                        const arma::mat& factor0, const arma::uvec& units) ;
+
+InterFit inter_fe_ub_core (const arma::mat& Y, const arma::cube& X,
+                           const arma::mat& I, int r, int force,
+                           const IterControl& ctl, const FactorEngine& engine,
+                           const arma::mat& factor0, const arma::uvec& units) ;
+
+/* the Lists returned by inter_fe and inter_fe_ub */
+Rcpp::List inter_fe_output (const InterFit& est, int p, int r, int force) ;
+
+Rcpp::List inter_fe_ub_output (const InterFit& est, int p, int r, int force) ;
+
+/* warm: fit at the previous lambda of a path (or NULL), replaced by this one */
+InterFit inter_fe_mc_core (const arma::mat& Y, const arma::cube& X,
+                           const arma::mat& I, int r, double lambda,
+                           int force, const IterControl& ctl, IterFit* warm) ;
+
+# endif
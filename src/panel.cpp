@@ -0,0 +1,171 @@
+# include "gsynth_types.h"
+# include <RcppArmadillo.h>
+# include <algorithm>
+# include <vector>
+// [[Rcpp::depends(RcppArmadillo)]]
+// [[Rcpp::plugins(cpp11)]]
+
+using namespace Rcpp ;
+
+/* ******************* Panel Construction  *********************** */
+
+/* Long to wide. Each row of the long data carries the codes of its
+   unit (1, ..., N) and period (1, ..., T), from match() against the
+   sorted unique ids and periods, so the cell of a row is known without
+   sorting the data: one pass scatters every variable into place.
+   Returns the T * N * nvar array of the variables, 0 at cells that are
+   not observed, and the T * N indicator I of the observed cells. A
+   (unit, period) pair that appears twice keeps its last row. */
+// [[Rcpp::export]]
+List panel_wide (const IntegerVector& id,
+                 const IntegerVector& time,
+                 const arma::mat& data, // rows: observations; columns: variables
+                 int N,
+                 int T
+                 ) {
+  int n = data.n_rows ;
+  int nvar = data.n_cols ;
+  if (id.size() != n || time.size() != n) {
+    Rcpp::stop("id, time and data must have the same number of rows.") ;
+  }
+
+  // cell of each row, column-major in a T * N slice
+  arma::uvec cell(n) ;
+  arma::mat I(T, N, arma::fill::zeros) ;
+  for (int k = 0; k < n; k++) {
+    // NA_INTEGER is INT_MIN: test it before subtracting
+    if (id[k] == NA_INTEGER || time[k] == NA_INTEGER) {
+      Rcpp::stop("unit or period code out of range.") ;
+    }
+    int i = id[k] - 1 ;
+    int t = time[k] - 1 ;
+    if (i < 0 || i >= N || t < 0 || t >= T) {
+      Rcpp::stop("unit or period code out of range.") ;
+    }
+    cell(k) = (arma::uword) i * T + t ;
+    I(cell(k)) = 1 ;
+  }
+
+  // variable by variable, so the reads run down a column of data
+  arma::cube V(T, N, nvar, arma::fill::zeros) ;
+  for (int v = 0; v < nvar; v++) {
+    const double* x = data.colptr(v) ;
+    double* y = V.slice(v).memptr() ;
+    for (int k = 0; k < n; k++) {
+      y[cell(k)] = x[k] ;
+    }
+  }
+
+  List output ;
+  output["data"] = V ;
+  output["I"] = I ;
+  return(output) ;
+}
+
+/* ******************* Treatment Structure  *********************** */
+
+/* Everything the estimators derive from the treatment indicator D and
+   the observation indicator I (T * N), in one scan of each column. With
+   absorb = 1, D is first made absorbing (once treated, always treated),
+   as gsynth does after reshaping; with absorb = 0 it is taken as is,
+   since cross-validation marks single pre-treatment periods as treated.
+   A unit is treated if D = 1 in the last period. For the treated units:
+   pre (post) marks the observed cells with D = 0 (D = 1); T0 counts the
+   pre cells and T0.ub the cells with D = 0; the pre cells are also
+   given in compressed form, pre.cell (1-based, column-major in
+   T * Ntr) with their unit pre.unit (1, ..., Ntr), and as the list
+   time.pre of each unit's pre-treatment periods. Units are grouped into
+   cohorts by the first period they are treated: cohort (per unit),
+   cohorts (the distinct adoption periods, sorted) and cohort.size. */
+// [[Rcpp::export]]
+List treat_index (arma::mat D,
+                  const arma::mat& I,
+                  int absorb = 1
+                  ) {
+  int T = D.n_rows ;
+  int N = D.n_cols ;
+
+  LogicalVector tr(N) ;
+  std::vector<int> id_tr ;
+  std::vector<int> id_co ;
+  for (int i = 0; i < N; i++) {
+    if (absorb == 1) {
+      double on = 0 ;
+      for (int t = 0; t < T; t++) {
+        if (D(t, i) != 0) {
+          on = 1 ;
+        }
+        D(t, i) = on ;
+      }
+    }
+    tr[i] = (D(T - 1, i) == 1) ;
+    if (tr[i]) {
+      id_tr.push_back(i + 1) ;
+    } else {
+      id_co.push_back(i + 1) ;
+    }
+  }
+
+  int Ntr = id_tr.size() ;
+  LogicalMatrix pre(T, Ntr) ;
+  LogicalMatrix post(T, Ntr) ;
+  IntegerVector T0(Ntr) ;
+  IntegerVector T0_ub(Ntr) ;
+  IntegerVector cohort(Ntr) ;
+  std::vector<int> pre_cell ;
+  std::vector<int> pre_unit ;
+  List time_pre(Ntr) ;
+  for (int j = 0; j < Ntr; j++) {
+    int i = id_tr[j] - 1 ;
+    std::vector<int> periods ;
+    cohort[j] = NA_INTEGER ;
+    for (int t = 0; t < T; t++) {
+      bool treated = D(t, i) != 0 ;
+      bool observed = I(t, i) != 0 ;
+      if (!treated) {
+        T0_ub[j]++ ;
+      } else if (cohort[j] == NA_INTEGER) {
+        cohort[j] = t + 1 ;
+      }
+      if (observed && !treated) {
+        pre(t, j) = true ;
+        T0[j]++ ;
+        pre_cell.push_back(j * T + t + 1) ;
+        pre_unit.push_back(j + 1) ;
+        periods.push_back(t + 1) ;
+      }
+      if (observed && treated) {
+        post(t, j) = true ;
+      }
+    }
+    time_pre[j] = wrap(periods) ;
+  }
+
+  // cohorts by adoption period
+  std::vector<int> cohorts(cohort.begin(), cohort.end()) ;
+  std::sort(cohorts.begin(), cohorts.end()) ;
+  cohorts.erase(std::unique(cohorts.begin(), cohorts.end()), cohorts.end()) ;
+  IntegerVector cohort_size(cohorts.size()) ;
+  for (int j = 0; j < Ntr; j++) {
+    int k = std::lower_bound(cohorts.begin(), cohorts.end(), (int) cohort[j])
+      - cohorts.begin() ;
+    cohort_size[k]++ ;
+  }
+
+  List output ;
+  output["D"] = D ;
+  output["tr"] = tr ;
+  output["id.tr"] = wrap(id_tr) ;
+  output["id.co"] = wrap(id_co) ;
+  output["pre"] = pre ;
+  output["post"] = post ;
+  output["T0"] = T0 ;
+  output["T0.ub"] = T0_ub ;
+  output["pre.cell"] = wrap(pre_cell) ;
+  output["pre.unit"] = wrap(pre_unit) ;
+  output["time.pre"] = time_pre ;
+  output["cohort"] = cohort ;
+  output["cohorts"] = wrap(cohorts) ;
+  output["cohort.size"] = cohort_size ;
+  return(output) ;
+}